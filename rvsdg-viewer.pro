@@ -1,9 +1,16 @@
-QT += widgets xml
+QT += widgets xml concurrent network
 QMAKE_CXXFLAGS += -g -std=gnu++11
 
-HEADERS       = src/mainwindow.h src/diagramscene.h src/diagramview.h src/model.h src/rvsdg-viewer.h src/element.h src/node.h src/region.h src/input.h src/output.h src/argument.h src/result.h
-SOURCES       = src/rvsdg-viewer.cpp src/mainwindow.cpp src/diagramscene.cpp src/model.cpp src/element.cpp src/node.cpp src/region.cpp
+HEADERS       = src/mainwindow.h src/diagramscene.h src/diagramview.h src/model.h src/rvsdg-viewer.h src/element.h src/node.h src/region.h src/input.h src/output.h src/argument.h src/result.h src/bitset.h src/dataflow.h src/search.h src/diff.h src/timeline.h src/stats.h src/profile.h src/memreport.h src/framestats.h src/tilecache.h src/spatialindex.h src/itempool.h src/highlight.h src/decompress.h src/liveframe.h src/livestream.h src/query.h
+SOURCES       = src/rvsdg-viewer.cpp src/mainwindow.cpp src/diagramscene.cpp src/model.cpp src/element.cpp src/node.cpp src/region.cpp src/dataflow.cpp src/search.cpp src/diff.cpp src/timeline.cpp src/stats.cpp src/profile.cpp src/memreport.cpp src/framestats.cpp src/diagramview.cpp src/tilecache.cpp src/spatialindex.cpp src/itempool.cpp src/highlight.cpp src/decompress.cpp src/livestream.cpp src/query.cpp
 RESOURCES     = application.qrc
+LIBS         += -lz
+
+# optional zstd input, enabled with: qmake CONFIG+=zstd
+zstd {
+  DEFINES += HAVE_ZSTD
+  LIBS    += -lzstd
+}
 
 # install
 target.path = /usr/bin/
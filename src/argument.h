@@ -12,8 +12,6 @@
 #include "element.h"
 
 class Argument : public Element {
-  QGraphicsPolygonItem *baseItem;
-
 public:
   Argument(QString id, Element *parent) : Element(id, 0, parent) {}
   unsigned getWidth() {
@@ -30,7 +28,7 @@ public:
             << QPointF(-INPUTOUTPUT_SIZE/2,-INPUTOUTPUT_SIZE)
             << QPointF(INPUTOUTPUT_SIZE/2,-INPUTOUTPUT_SIZE);
 
-    baseItem = new QGraphicsPolygonItem(polygon, parent);
+    baseItem = ItemPool::polygon(polygon, parent);
     baseItem->setData(0, QVariant::fromValue((void*)this));
   }
   void setPos(unsigned x, unsigned y) {
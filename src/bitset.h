@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ * Simple dynamically sized bitset
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <vector>
+#include <algorithm>
+#include <QtGlobal>
+
+class Bitset {
+  std::vector<quint64> words;
+
+public:
+  Bitset(unsigned size = 0) {
+    resize(size);
+  }
+  void resize(unsigned size) {
+    words.resize((size + 63) / 64, 0);
+  }
+  void set(unsigned n) {
+    words[n / 64] |= (quint64)1 << (n % 64);
+  }
+  void reset(unsigned n) {
+    words[n / 64] &= ~((quint64)1 << (n % 64));
+  }
+  bool test(unsigned n) const {
+    return (words[n / 64] >> (n % 64)) & 1;
+  }
+  void clear() {
+    std::fill(words.begin(), words.end(), 0);
+  }
+
+  // growing variants, for sets that start out empty and are filled sparsely
+
+  /* sets bit n, growing the set if needed */
+  void insert(unsigned n) {
+    if(n / 64 >= words.size()) words.resize(n / 64 + 1, 0);
+    set(n);
+  }
+  /* resets bit n, if it is in the set */
+  void remove(unsigned n) {
+    if(n / 64 < words.size()) reset(n);
+  }
+  /* tests bit n, bits beyond the set are 0 */
+  bool contains(unsigned n) const {
+    return (n / 64 < words.size()) && test(n);
+  }
+  /* empties the set in O(1), by releasing its storage */
+  void release() {
+    std::vector<quint64>().swap(words);
+  }
+  bool any() const {
+    for(auto word : words) {
+      if(word) return true;
+    }
+    return false;
+  }
+  void intersect(const Bitset &other) {
+    if(words.size() > other.words.size()) words.resize(other.words.size());
+    for(unsigned i = 0; i < words.size(); i++) {
+      words[i] &= other.words[i];
+    }
+  }
+};
+
+#endif
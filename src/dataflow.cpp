@@ -0,0 +1,179 @@
+#include <climits>
+#include <algorithm>
+
+#include "dataflow.h"
+#include "bitset.h"
+#include "node.h"
+#include "region.h"
+
+void Adjacency::build(const std::vector<FlowLink> &links, unsigned numVertices, bool forward) {
+  offsets.assign(numVertices + 1, 0);
+  vertices.resize(links.size());
+  edges.resize(links.size());
+
+  for(auto &link : links) {
+    offsets[(forward ? link.source : link.target) + 1]++;
+  }
+  for(unsigned i = 0; i < numVertices; i++) {
+    offsets[i+1] += offsets[i];
+  }
+
+  std::vector<unsigned> fill(offsets.begin(), offsets.end() - 1);
+  for(auto &link : links) {
+    unsigned from = forward ? link.source : link.target;
+    unsigned pos = fill[from]++;
+    vertices[pos] = forward ? link.target : link.source;
+    edges[pos] = link.edge;
+  }
+}
+
+Dataflow::Dataflow(const std::vector<Element*> &vertices) {
+  this->vertices = vertices;
+
+  // successors are built from the outgoing edges and predecessors from the incoming
+  // edges, one list of links at a time
+  std::vector<FlowLink> links;
+  for(auto vertex : vertices) {
+    vertex->appendFlowLinks(links, true);
+  }
+  successors.build(links, vertices.size(), true);
+
+  links.clear();
+  for(auto vertex : vertices) {
+    vertex->appendFlowLinks(links, false);
+  }
+  predecessors.build(links, vertices.size(), false);
+}
+
+void Dataflow::startVertices(Element *element, bool forward, std::vector<unsigned> &start) {
+  if((element->number >= vertices.size()) || (vertices[element->number] != element)) {
+    return;
+  }
+
+  if(element->isComplexNode()) {
+    Node *node = (Node*)element;
+    for(auto port : forward ? node->outputs : node->inputs) {
+      start.push_back(port->number);
+    }
+  } else if(element->isRegion()) {
+    Region *region = (Region*)element;
+    for(auto port : forward ? region->arguments : region->results) {
+      start.push_back(port->number);
+    }
+  } else {
+    start.push_back(element->number);
+  }
+}
+
+void Dataflow::trace(Element *element, bool forward, std::vector<Edge*> &edges) {
+  Adjacency &adjacency = forward ? successors : predecessors;
+  Bitset visited(vertices.size());
+  std::vector<unsigned> worklist;
+
+  startVertices(element, forward, worklist);
+  for(auto v : worklist) {
+    visited.set(v);
+  }
+
+  while(worklist.size()) {
+    unsigned v = worklist.back();
+    worklist.pop_back();
+
+    for(unsigned i = adjacency.offsets[v]; i < adjacency.offsets[v+1]; i++) {
+      if(adjacency.edges[i]) edges.push_back(adjacency.edges[i]);
+
+      unsigned w = adjacency.vertices[i];
+      if(!visited.test(w)) {
+        visited.set(w);
+        worklist.push_back(w);
+      }
+    }
+  }
+}
+
+/* expands one breadth first level of a search, returns the length of the
+   shortest path found through a vertex reached by the other search, UINT_MAX if none */
+static unsigned expandLevel(const Adjacency &adjacency, std::vector<unsigned> &frontier,
+                            std::vector<unsigned> &dist, std::vector<unsigned> &from, std::vector<unsigned> &via,
+                            const std::vector<unsigned> &otherDist, unsigned &meet) {
+  unsigned best = UINT_MAX;
+  std::vector<unsigned> next;
+
+  for(auto v : frontier) {
+    for(unsigned i = adjacency.offsets[v]; i < adjacency.offsets[v+1]; i++) {
+      unsigned w = adjacency.vertices[i];
+      if(dist[w] != UINT_MAX) continue;
+
+      dist[w] = dist[v] + 1;
+      from[w] = v;
+      via[w] = i;
+      next.push_back(w);
+
+      if((otherDist[w] != UINT_MAX) && (dist[w] + otherDist[w] < best)) {
+        best = dist[w] + otherDist[w];
+        meet = w;
+      }
+    }
+  }
+
+  frontier.swap(next);
+  return best;
+}
+
+bool Dataflow::shortestPath(Element *source, Element *target, std::vector<Element*> &pathVertices, std::vector<Edge*> &pathEdges) {
+  std::vector<unsigned> forwardFrontier;
+  std::vector<unsigned> backwardFrontier;
+  startVertices(source, true, forwardFrontier);
+  startVertices(target, false, backwardFrontier);
+  if(forwardFrontier.empty() || backwardFrontier.empty()) return false;
+
+  // distance from the source or to the target, the previous vertex in the search,
+  // and the adjacency position of the link used to get there
+  std::vector<unsigned> forwardDist(vertices.size(), UINT_MAX);
+  std::vector<unsigned> backwardDist(vertices.size(), UINT_MAX);
+  std::vector<unsigned> forwardFrom(vertices.size(), UINT_MAX);
+  std::vector<unsigned> backwardFrom(vertices.size(), UINT_MAX);
+  std::vector<unsigned> forwardVia(vertices.size());
+  std::vector<unsigned> backwardVia(vertices.size());
+
+  unsigned meet = UINT_MAX;
+  for(auto v : forwardFrontier) forwardDist[v] = 0;
+  for(auto v : backwardFrontier) {
+    backwardDist[v] = 0;
+    if(forwardDist[v] == 0) meet = v;
+  }
+
+  // grow the smaller frontier one level at a time, the first level where the searches
+  // meet holds a shortest path
+  while((meet == UINT_MAX) && forwardFrontier.size() && backwardFrontier.size()) {
+    unsigned best;
+    if(forwardFrontier.size() <= backwardFrontier.size()) {
+      best = expandLevel(successors, forwardFrontier, forwardDist, forwardFrom, forwardVia, backwardDist, meet);
+    } else {
+      best = expandLevel(predecessors, backwardFrontier, backwardDist, backwardFrom, backwardVia, forwardDist, meet);
+    }
+    if(best != UINT_MAX) break;
+  }
+  if(meet == UINT_MAX) return false;
+
+  // from the meeting vertex back to the source
+  std::vector<Element*> vertexPath(1, vertices[meet]);
+  std::vector<Edge*> edgePath;
+  for(unsigned v = meet; forwardFrom[v] != UINT_MAX; v = forwardFrom[v]) {
+    if(successors.edges[forwardVia[v]]) edgePath.push_back(successors.edges[forwardVia[v]]);
+    vertexPath.push_back(vertices[forwardFrom[v]]);
+  }
+  std::reverse(vertexPath.begin(), vertexPath.end());
+  std::reverse(edgePath.begin(), edgePath.end());
+
+  // and on to the target
+  for(unsigned v = meet; backwardFrom[v] != UINT_MAX; v = backwardFrom[v]) {
+    if(predecessors.edges[backwardVia[v]]) edgePath.push_back(predecessors.edges[backwardVia[v]]);
+    vertexPath.push_back(vertices[backwardFrom[v]]);
+  }
+
+  pathVertices.insert(pathVertices.end(), vertexPath.begin(), vertexPath.end());
+  pathEdges.insert(pathEdges.end(), edgePath.begin(), edgePath.end());
+
+  return true;
+}
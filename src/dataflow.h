@@ -0,0 +1,79 @@
+/******************************************************************************
+ *
+ * Dataflow index, used for tracing values through the RVSDG graph
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include <vector>
+
+#include "element.h"
+
+class Edge;
+
+/* one link in the dataflow graph, either an edge or an implicit link
+   through a node (edge is then NULL) */
+class FlowLink {
+public:
+  unsigned source;
+  unsigned target;
+  Edge *edge;
+
+  FlowLink(unsigned source, unsigned target, Edge *edge) {
+    this->source = source;
+    this->target = target;
+    this->edge = edge;
+  }
+};
+
+/* compressed sparse row adjacency lists */
+class Adjacency {
+public:
+  std::vector<unsigned> offsets;
+  std::vector<unsigned> vertices;
+  std::vector<Edge*> edges;
+
+  void build(const std::vector<FlowLink> &links, unsigned numVertices, bool forward);
+
+  quint64 getMemoryUsage() const {
+    return offsets.capacity() * sizeof(unsigned) + vertices.capacity() * sizeof(unsigned)
+      + edges.capacity() * sizeof(Edge*);
+  }
+};
+
+class Dataflow {
+  std::vector<Element*> vertices;
+  Adjacency successors;
+  Adjacency predecessors;
+
+  void startVertices(Element *element, bool forward, std::vector<unsigned> &start);
+
+public:
+  Dataflow(const std::vector<Element*> &vertices);
+
+  /* finds all edges reachable from the given element, following the
+     dataflow forward (uses) or backward (dependencies) */
+  void trace(Element *element, bool forward, std::vector<Edge*> &edges);
+
+  /* finds a shortest dataflow path from source to target with a bidirectional
+     breadth first search, crossing region boundaries through arguments and results
+     returns false if target is not reachable, otherwise appends the vertices and
+     edges of the path in order */
+  bool shortestPath(Element *source, Element *target, std::vector<Element*> &pathVertices, std::vector<Edge*> &pathEdges);
+
+  /* number of links out of an element, for outputs and arguments its edges */
+  unsigned getNumSuccessors(Element *element) const {
+    return successors.offsets[element->number + 1] - successors.offsets[element->number];
+  }
+
+  quint64 getMemoryUsage() const {
+    return sizeof(Dataflow) + vertices.capacity() * sizeof(Element*)
+      + successors.getMemoryUsage() + predecessors.getMemoryUsage();
+  }
+};
+
+#endif
@@ -0,0 +1,269 @@
+#include <QFile>
+#include <QThread>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "decompress.h"
+#include "rvsdg-viewer.h"
+
+class DecompressThread : public QThread {
+  DecompressDevice *device;
+
+public:
+  DecompressThread(DecompressDevice *device) {
+    this->device = device;
+  }
+  void run() Q_DECL_OVERRIDE {
+    device->produce();
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+DecompressDevice::DecompressDevice(const QString &fileName, Compression compression, QObject *parent) : QIODevice(parent) {
+  this->fileName = fileName;
+  this->compression = compression;
+  thread = NULL;
+  finished = aborted = false;
+  offset = 0;
+}
+
+DecompressDevice::~DecompressDevice() {
+  close();
+}
+
+Compression DecompressDevice::detect(const QString &fileName) {
+  QFile file(fileName);
+  if(!file.open(QIODevice::ReadOnly)) return COMPRESSION_NONE;
+
+  QByteArray magic = file.read(4);
+  if(magic.startsWith("\x1f\x8b")) return COMPRESSION_GZIP;
+  if(magic == QByteArray("\x28\xb5\x2f\xfd", 4)) return COMPRESSION_ZSTD;
+  return COMPRESSION_NONE;
+}
+
+bool DecompressDevice::open(OpenMode mode) {
+  if(mode & QIODevice::WriteOnly) return false;
+
+#ifndef HAVE_ZSTD
+  if(compression == COMPRESSION_ZSTD) {
+    setErrorString("Zstandard support not compiled in");
+    return false;
+  }
+#endif
+
+  if(!QFile::exists(fileName)) {
+    setErrorString("File not found");
+    return false;
+  }
+
+  finished = aborted = false;
+  error.clear();
+  chunks.clear();
+  current.clear();
+  offset = 0;
+
+  thread = new DecompressThread(this);
+  thread->start();
+
+  return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void DecompressDevice::close() {
+  if(thread) {
+    mutex.lock();
+    aborted = true;
+    notFull.wakeAll();
+    mutex.unlock();
+
+    thread->wait();
+    delete thread;
+    thread = NULL;
+  }
+  chunks.clear();
+  current.clear();
+
+  QIODevice::close();
+}
+
+bool DecompressDevice::atEnd() const {
+  QMutexLocker locker(&mutex);
+  return finished && chunks.isEmpty() && (offset >= current.size());
+}
+
+qint64 DecompressDevice::bytesAvailable() const {
+  QMutexLocker locker(&mutex);
+  qint64 size = current.size() - offset;
+  for(auto &chunk : chunks) size += chunk.size();
+  return size + QIODevice::bytesAvailable();
+}
+
+bool DecompressDevice::failed() const {
+  QMutexLocker locker(&mutex);
+  return !error.isEmpty();
+}
+
+/* blocks until some data is decompressed, returns 0 only at the end of the file */
+qint64 DecompressDevice::readData(char *data, qint64 maxSize) {
+  if(offset >= current.size()) {
+    QMutexLocker locker(&mutex);
+    while(chunks.isEmpty() && !finished) {
+      notEmpty.wait(&mutex);
+    }
+    if(chunks.isEmpty()) {
+      if(!error.isEmpty()) {
+        setErrorString(error);
+        return -1;
+      }
+      return 0;
+    }
+    current = chunks.dequeue();
+    offset = 0;
+    notFull.wakeOne();
+  }
+
+  qint64 size = qMin(maxSize, (qint64)(current.size() - offset));
+  memcpy(data, current.constData() + offset, size);
+  offset += size;
+
+  return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// producer, runs in the decompression thread
+
+/* queues a chunk of decompressed data, returns false if the consumer closed the device */
+bool DecompressDevice::push(const char *data, int size) {
+  QMutexLocker locker(&mutex);
+  while((chunks.size() >= DECOMPRESS_QUEUE_LENGTH) && !aborted) {
+    notFull.wait(&mutex);
+  }
+  if(aborted) return false;
+
+  chunks.enqueue(QByteArray(data, size));
+  notEmpty.wakeOne();
+
+  return true;
+}
+
+void DecompressDevice::produce() {
+  QFile file(fileName);
+
+  if(!file.open(QIODevice::ReadOnly)) {
+    mutex.lock();
+    error = "File not found";
+    mutex.unlock();
+  } else if(compression == COMPRESSION_GZIP) {
+    produceGzip(file);
+  } else {
+    produceZstd(file);
+  }
+
+  mutex.lock();
+  finished = true;
+  notEmpty.wakeAll();
+  mutex.unlock();
+}
+
+bool DecompressDevice::produceGzip(QIODevice &file) {
+  QByteArray in(DECOMPRESS_CHUNK_SIZE, 0);
+  QByteArray out(DECOMPRESS_CHUNK_SIZE, 0);
+
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.next_in = Z_NULL;
+  stream.avail_in = 0;
+  if(inflateInit2(&stream, 15 + 32) != Z_OK) { // 32: detect gzip or zlib header
+    QMutexLocker locker(&mutex);
+    error = "Could not initialize zlib";
+    return false;
+  }
+
+  int ret = Z_OK;
+  bool ok = true;
+  bool pending = false; // output was full, inflate may have more before needing input
+
+  while(ok) {
+    if((stream.avail_in == 0) && !pending) {
+      qint64 size = file.read(in.data(), in.size());
+      if(size <= 0) break;
+      stream.next_in = (Bytef*)in.data();
+      stream.avail_in = size;
+    }
+
+    stream.next_out = (Bytef*)out.data();
+    stream.avail_out = out.size();
+    ret = inflate(&stream, Z_NO_FLUSH);
+    if((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR)) break;
+
+    unsigned size = out.size() - stream.avail_out;
+    if(size) ok = push(out.constData(), size);
+    pending = (stream.avail_out == 0);
+
+    // concatenated gzip members, as written by e.g. pigz or appending
+    if((ret == Z_STREAM_END) && !pending) {
+      if((stream.avail_in == 0) && file.atEnd()) break;
+      inflateReset(&stream);
+    }
+  }
+
+  inflateEnd(&stream);
+
+  if(ok && (ret != Z_STREAM_END)) {
+    QMutexLocker locker(&mutex);
+    error = "Corrupt or truncated gzip file";
+    return false;
+  }
+
+  return ok;
+}
+
+bool DecompressDevice::produceZstd(QIODevice &file) {
+#ifdef HAVE_ZSTD
+  QByteArray in(ZSTD_DStreamInSize(), 0);
+  QByteArray out(ZSTD_DStreamOutSize(), 0);
+
+  ZSTD_DStream *stream = ZSTD_createDStream();
+  ZSTD_initDStream(stream);
+
+  size_t ret = 1; // nonzero until a frame is complete
+  bool ok = true;
+
+  while(ok) {
+    qint64 size = file.read(in.data(), in.size());
+    if(size <= 0) break;
+
+    ZSTD_inBuffer input = { in.constData(), (size_t)size, 0 };
+    bool pending = true; // output was full, the decoder may have more buffered
+    while(ok && ((input.pos < input.size) || pending)) {
+      ZSTD_outBuffer output = { out.data(), (size_t)out.size(), 0 };
+      ret = ZSTD_decompressStream(stream, &output, &input);
+      if(ZSTD_isError(ret)) {
+        ok = false;
+        break;
+      }
+      if(output.pos) ok = push(out.constData(), output.pos);
+      pending = (output.pos == output.size);
+    }
+  }
+
+  ZSTD_freeDStream(stream);
+
+  if(ret != 0) {
+    QMutexLocker locker(&mutex);
+    if(!aborted) error = "Corrupt or truncated zstd file";
+    return false;
+  }
+
+  return ok;
+#else
+  Q_UNUSED(file);
+  QMutexLocker locker(&mutex);
+  error = "Zstandard support not compiled in";
+  return false;
+#endif
+}
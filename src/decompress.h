@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ * Read-only device decompressing a gzip or zstd file in a background thread
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef DECOMPRESS_H
+#define DECOMPRESS_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+
+enum Compression {
+  COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD
+};
+
+class DecompressThread;
+
+/* The file is decompressed in chunks into a bounded queue while the reader
+   consumes it, so decompression overlaps parsing and the decompressed data
+   is never held in memory as a whole. */
+class DecompressDevice : public QIODevice {
+  friend class DecompressThread;
+
+  QString fileName;
+  Compression compression;
+  DecompressThread *thread;
+
+  mutable QMutex mutex;
+  QWaitCondition notEmpty;
+  QWaitCondition notFull;
+  QQueue<QByteArray> chunks;
+  bool finished; // producer is done, no more chunks will be queued
+  bool aborted;  // consumer is closing, producer should stop
+  QString error; // set by the producer on failure
+
+  QByteArray current; // chunk being read
+  int offset;         // read position in current
+
+  void produce();
+  bool produceGzip(QIODevice &file);
+  bool produceZstd(QIODevice &file);
+  bool push(const char *data, int size);
+
+public:
+  DecompressDevice(const QString &fileName, Compression compression, QObject *parent = 0);
+  ~DecompressDevice();
+
+  /* compression of a file, from its magic number */
+  static Compression detect(const QString &fileName);
+
+  bool open(OpenMode mode) Q_DECL_OVERRIDE;
+  void close() Q_DECL_OVERRIDE;
+  bool isSequential() const Q_DECL_OVERRIDE {
+    return true;
+  }
+  bool atEnd() const Q_DECL_OVERRIDE;
+  qint64 bytesAvailable() const Q_DECL_OVERRIDE;
+
+  /* true if decompression failed, errorString() has the reason */
+  bool failed() const;
+
+protected:
+  qint64 readData(char *data, qint64 maxSize) Q_DECL_OVERRIDE;
+  qint64 writeData(const char *data, qint64 maxSize) Q_DECL_OVERRIDE {
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+  }
+};
+
+#endif
@@ -1,66 +1,395 @@
 #include "diagramscene.h"
+#include "region.h"
+#include "model.h"
+#include "memreport.h"
 
 #include <QTextCursor>
 #include <QGraphicsSceneMouseEvent>
 #include <QGraphicsEllipseItem>
+#include <QGraphicsSceneHelpEvent>
+#include <QToolTip>
 
-extern QColor edgeColors[];
-
-DiagramScene::DiagramScene(QComboBox *colorBox, QObject *parent) : QGraphicsScene(parent) {
+DiagramScene::DiagramScene(QComboBox *colorBox, QComboBox *traceBox, QObject *parent) : QGraphicsScene(parent) {
   this->colorBox = colorBox;
-  zvalue = 1;
+  this->traceBox = traceBox;
+  lastElement = NULL;
+  summaryBudget = SUMMARY_BUDGET;
+  model = NULL;
+  memoryBudget = MEMORY_BUDGET;
+  profile = NULL;
+  metric = -1;
+  highlights = NULL;
+  pathSource = NULL;
+  root = NULL;
 }
 
 void DiagramScene::drawElement(Element *element) {
   lastElement = element;
 
-  clear();
+  Region::drawBudget = summaryBudget;
+  Region::drawStamp++;
+
+  // items from the previous draw are reused, and the index is rebuilt once afterwards
+  // instead of being updated for every moved item
+  setItemIndexMethod(QGraphicsScene::NoIndex);
+
+  if(!root) {
+    root = new QGraphicsLineItem();
+    addItem(root);
+  }
 
-  QGraphicsLineItem *item = new QGraphicsLineItem();
-  item->setPos(0,0);
-  element->appendItems(item);
+  pool.begin();
+  element->appendItems(root);
   element->setPos(0,0);
+  pool.end();
 
-  addItem(item);
+  setItemIndexMethod(QGraphicsScene::BspTreeIndex);
 
   setSceneRect(QRectF(0, 0, element->getWidth(), element->getHeight()));
+
+  // index the final geometry for picking
+  unsigned order = 0;
+  pickIndex.clear();
+  if(element->isRegion()) {
+    pickIndex.insert(PickEntry(QRectF(0, 0, element->getWidth(), element->getHeight()), NULL, NULL, order++));
+  }
+  indexElement(element, order);
+  pickIndex.build();
+
+  recolor();
+  if(profile) retint();
+
+  evict();
+
+  MemoryReport::samplePeak("draw");
+}
+
+/* keeps what is cached between draws within the memory budget, cheapest to rebuild first:
+   hidden items, then layouts of regions not drawn recently, then the layering cache.
+   Anything in the current draw is kept, evicted data is rebuilt when next drawn */
+void DiagramScene::evict() {
+  quint64 layouts = model ? model->getLayoutMemory() : 0;
+  quint64 layers = Region::getLayerCacheMemory();
+
+  quint64 itemBudget = memoryBudget > layouts + layers ? memoryBudget - layouts - layers : 0;
+  pool.trim(itemBudget / IDLE_ITEM_BYTES);
+
+  quint64 items = (quint64)pool.getNumIdle() * IDLE_ITEM_BYTES;
+  if(model && (items + layouts + layers > memoryBudget)) {
+    model->evictLayouts(memoryBudget > items + layers ? memoryBudget - items - layers : 0);
+    layouts = model->getLayoutMemory();
+  }
+
+  if(items + layouts + layers > memoryBudget) {
+    Region::trimLayerCache(memoryBudget > items + layouts ? memoryBudget - items - layouts : 0);
+  }
+}
+
+/* redraws after live updates to the model, which may have removed the drawn element */
+void DiagramScene::modelChanged() {
+  if(pathSource && !model->isAttached(pathSource)) pathSource = NULL;
+
+  if(lastElement && model->isAttached(lastElement)) {
+    drawElement(lastElement);
+  } else if(lastElement) {
+    clearElement();
+  }
+}
+
+/* updates the pens of all edge line items in one pass, after edge colors have changed */
+void DiagramScene::recolor() {
+  if(highlights) highlights->update();
+
+  for(auto item : items()) {
+    QGraphicsLineItem *line = qgraphicsitem_cast<QGraphicsLineItem*>(item);
+    if(line) {
+      Edge *edge = (Edge*)line->data(1).value<void*>();
+      if(edge) applyHighlight(line, edge);
+    }
+  }
+}
+
+/* sets pen color and stacking order of a line item from the highlight layers */
+void DiagramScene::applyHighlight(QGraphicsLineItem *line, Edge *edge) {
+  QColor color = Qt::black;
+  unsigned z = 0;
+  if(highlights) highlights->getColor(edge->number, color, z);
+
+  QPen pen = line->pen();
+  pen.setColor(color);
+  line->setPen(pen);
+  line->setZValue(z);
+}
+
+/* tints node boxes and sets edge widths according to the selected profile metric
+   only touches existing items, no layout is done */
+void DiagramScene::retint() {
+  bool active = profile && (metric >= 0);
+
+  for(auto item : items()) {
+    QGraphicsLineItem *line = qgraphicsitem_cast<QGraphicsLineItem*>(item);
+    if(line) {
+      Edge *edge = (Edge*)line->data(1).value<void*>();
+      if(edge) {
+        float heat;
+        QPen pen = line->pen();
+        if(active && profile->getHeat(metric, edge->source, heat)) {
+          pen.setWidthF(1 + heat * (HEAT_MAX_PEN_WIDTH - 1));
+        } else {
+          pen.setWidthF(1); // the width of the default pen edges are drawn with
+        }
+        line->setPen(pen);
+      }
+      continue;
+    }
+
+    QGraphicsPolygonItem *poly = qgraphicsitem_cast<QGraphicsPolygonItem*>(item);
+    if(poly) {
+      Element *el = (Element*)poly->data(0).value<void*>();
+      if(el && (el->isSimpleNode() || el->isComplexNode()) && (el->getBaseItem() == poly)) {
+        float heat;
+        if(active && profile->getHeat(metric, el, heat)) {
+          poly->setBrush(QBrush(QColor::fromHsvF((1 - heat) * HEAT_COLD_HUE, 1, 1)));
+        } else {
+          poly->setBrush(QBrush(((Node*)el)->getColor()));
+        }
+      }
+    }
+  }
+}
+
+/* adds the drawn element and its drawn contents to the pick index, in stacking order */
+void DiagramScene::indexElement(Element *element, unsigned &order) {
+  if(element->isRegion()) {
+    Region *region = (Region*)element;
+
+    if(region->getBaseItem()) {
+      // summarized
+      pickIndex.insert(PickEntry(region->getBaseItem()->sceneBoundingRect(), region, NULL, order++));
+      return;
+    }
+
+    for(auto argument : region->arguments) {
+      indexElement(argument, order);
+    }
+    for(auto child : region->children) {
+      indexElement(child, order);
+    }
+    for(auto result : region->results) {
+      indexElement(result, order);
+    }
+
+    // edges are drawn on top of the vertices
+    for(auto argument : region->arguments) {
+      indexEdges(argument, order);
+    }
+    for(auto child : region->children) {
+      for(auto output : ((Node*)child)->outputs) {
+        indexEdges(output, order);
+      }
+    }
+    return;
+  }
+
+  QGraphicsItem *baseItem = element->getBaseItem();
+  if(!baseItem) return;
+  pickIndex.insert(PickEntry(baseItem->sceneBoundingRect(), element, NULL, order++));
+
+  if(element->isSimpleNode() || element->isComplexNode()) {
+    Node *node = (Node*)element;
+    for(auto input : node->inputs) {
+      indexElement(input, order);
+    }
+    if(node->isExpanded()) {
+      for(auto child : node->children) {
+        // the region background hides the node below it
+        QRectF rect(child->getX(), child->getY(), child->getWidth(), child->getHeight());
+        pickIndex.insert(PickEntry(baseItem->mapRectToScene(rect), NULL, NULL, order++));
+        indexElement(child, order);
+      }
+    }
+    for(auto output : node->outputs) {
+      indexElement(output, order);
+    }
+  }
+}
+
+/* adds the segments of the edges leaving port */
+void DiagramScene::indexEdges(Element *port, unsigned &order) {
+  for(auto segment : port->getLineSegments()) {
+    if(segment.edge->source != port) continue;
+    QLineF line = segment.item->line();
+    QRectF rect = segment.item->mapRectToScene(QRectF(line.p1(), line.p2()).normalized());
+    pickIndex.insert(PickEntry(rect.adjusted(-PICK_TOLERANCE, -PICK_TOLERANCE, PICK_TOLERANCE, PICK_TOLERANCE),
+                               NULL, segment.edge, order++));
+  }
+}
+
+/* adds (mark) or removes the edges of element, or all edges reachable from it
+   when tracing, to the highlight layer of the selected color
+   returns true if the scene must be recolored */
+bool DiagramScene::markElement(Element *el, bool mark) {
+  if(!highlights) return false;
+
+  unsigned layer = colorBox->currentIndex();
+  bool raised = mark && highlights->touch(layer);
+
+  if(model && (traceBox->currentIndex() != TRACE_NONE)) {
+    // all edges transitively reachable from the element
+    std::vector<Edge*> edges;
+    model->getDataflow()->trace(el, traceBox->currentIndex() == TRACE_FORWARD, edges);
+
+    for(auto edge : edges) {
+      if(mark) highlights->mark(layer, edge->number);
+      else highlights->unmark(layer, edge->number);
+    }
+
+    return true;
+  }
+
+  std::vector<LineSegment> lines = el->getLineSegments();
+  for(auto line : lines) {
+    if(mark) highlights->mark(layer, line.edge->number);
+    else highlights->unmark(layer, line.edge->number);
+  }
+
+  // overlap mode depends on all edges, and raising the layer changes the color of
+  // its other edges where layers share them, otherwise only these lines change
+  if(raised || highlights->getOverlapOnly()) return true;
+
+  for(auto line : lines) {
+    applyHighlight(line.item, line.edge);
+  }
+
+  return false;
 }
 
 void DiagramScene::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent) {
   if((mouseEvent->button() == Qt::LeftButton) || (mouseEvent->button() == Qt::RightButton)) {
-    QGraphicsItem *item = itemAt(mouseEvent->scenePos(), QTransform());
-    Element *el = (Element*)item->data(0).value<void*>();
+    const PickEntry *hit = pick(mouseEvent->scenePos());
+    Element *el = hit ? hit->element : NULL;
     if(el) {
-      std::vector<LineSegment> lines = el->getLineSegments();
-      for(auto line : lines) {
-        QPen pen = line.item->pen();
-
-        if(mouseEvent->button() == Qt::LeftButton) {
-          line.edge->color = colorBox->currentIndex();
-          line.edge->zvalue = zvalue++;
-          pen.setColor(edgeColors[line.edge->color]);
+      emit elementSelected(el);
+
+      // ctrl-click selects the two ends of a path
+      if((mouseEvent->button() == Qt::LeftButton) && (mouseEvent->modifiers() & Qt::ControlModifier)) {
+        if(!pathSource) {
+          pathSource = el;
+          emit statusMessage(tr("Path from %1 %2, ctrl-click the target").arg(el->getTypeName()).arg(el->id));
         } else {
-          pen.setColor(Qt::black);
-          line.edge->color = -1;
-          line.edge->zvalue = 0;
+          Element *source = pathSource;
+          pathSource = NULL;
+          showPath(source, el);
         }
-
-        line.item->setPen(pen);
-        line.item->setZValue(line.edge->zvalue);
+        return;
       }
+
+      if(markElement(el, mouseEvent->button() == Qt::LeftButton)) recolor();
     }
   }
 }
 
+static bool isAncestor(Element *ancestor, Element *el) {
+  for(; el; el = el->parent) {
+    if(el == ancestor) return true;
+  }
+  return false;
+}
+
+/* highlights a shortest dataflow path from source to target, expands the nodes
+   it passes through and draws an element containing all of it */
+bool DiagramScene::showPath(Element *source, Element *target) {
+  if(!model || !highlights) return false;
+
+  std::vector<Element*> vertices;
+  std::vector<Edge*> edges;
+  if(!model->getDataflow()->shortestPath(source, target, vertices, edges)) {
+    emit statusMessage(tr("No dataflow path from %1 to %2").arg(source->id).arg(target->id));
+    return false;
+  }
+
+  highlights->clearPath();
+  for(auto edge : edges) {
+    highlights->markPath(edge->number);
+  }
+
+  // the regions holding the path vertices, and the lowest element containing them all
+  std::vector<Element*> containers;
+  Element *top = lastElement;
+  for(auto vertex : vertices) {
+    Element *container = vertex->getVertex()->parent;
+    if(!container) continue;
+    containers.push_back(container);
+
+    if(!top) top = container;
+    while(!isAncestor(top, container)) top = top->parent;
+  }
+  if(!top) return false;
+  if(!top->parent && (top->children.size() == 1)) top = top->children[0];
+
+  for(auto container : containers) {
+    for(Element *el = container; el; el = el->parent) {
+      if(el->isComplexNode()) ((Node*)el)->setExpanded(true);
+      else if(el->isRegion()) ((Region*)el)->setShowAll(true);
+      if(el == top) break;
+    }
+  }
+
+  drawElement(top);
+
+  emit statusMessage(tr("Path from %1 to %2: %3 edges").arg(source->id).arg(target->id).arg(edges.size()));
+  return true;
+}
+
+/* marks all elements inside rect, as if each was clicked */
+void DiagramScene::markRect(const QRectF &rect, bool mark) {
+  std::vector<const PickEntry*> hits;
+  pickIndex.query(rect, hits);
+
+  bool changed = false;
+  for(auto hit : hits) {
+    if(hit->element && rect.contains(hit->box)) {
+      changed |= markElement(hit->element, mark);
+    }
+  }
+  if(changed) recolor();
+}
+
+void DiagramScene::helpEvent(QGraphicsSceneHelpEvent *helpEvent) {
+  const PickEntry *hit = pick(helpEvent->scenePos());
+
+  QString text;
+  if(hit && hit->element) {
+    text = hit->element->getTypeName() + " " + hit->element->id;
+    if(hit->element->isSimpleNode() || hit->element->isComplexNode()) {
+      QString name = ((Node*)hit->element)->getName();
+      if(!name.isEmpty()) text += "\n" + name;
+    }
+  } else if(hit && hit->edge) {
+    text = hit->edge->source->id + " -> " + hit->edge->target->id;
+  }
+
+  if(text.isEmpty()) {
+    QToolTip::hideText();
+  } else {
+    QToolTip::showText(helpEvent->screenPos(), text, helpEvent->widget());
+  }
+  helpEvent->setAccepted(!text.isEmpty());
+}
+
 void DiagramScene::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *mouseEvent) {
   if (mouseEvent->button() == Qt::LeftButton) {
-    QGraphicsItem *item = itemAt(mouseEvent->scenePos(), QTransform());
-    Element *el = (Element*)item->data(0).value<void*>();
+    const PickEntry *hit = pick(mouseEvent->scenePos());
+    Element *el = hit ? hit->element : NULL;
     if(el) {
       if(el->isComplexNode()) {
         Node *node = (Node*)el;
         node->toggleExpanded();
         drawElement(lastElement);
+      } else if(el->isRegion()) {
+        // summarized region, draw its contents
+        ((Region*)el)->setShowAll(true);
+        drawElement(lastElement);
       }
     }
   }
@@ -12,25 +12,103 @@
 #include <QtWidgets>
 #include <QGraphicsScene>
 #include "node.h"
+#include "dataflow.h"
+#include "profile.h"
+#include "spatialindex.h"
+#include "highlight.h"
+
+class Model;
+
+enum TraceMode {
+  TRACE_NONE, TRACE_FORWARD, TRACE_BACKWARD
+};
 
 class DiagramScene : public QGraphicsScene {
   Q_OBJECT
 
-  unsigned zvalue;
   Element *lastElement;
   QComboBox *colorBox;
+  QComboBox *traceBox;
+  Highlights *highlights;
+  Element *pathSource; // first end of a path being selected, NULL if none
+  unsigned summaryBudget;
+  Model *model;
+  quint64 memoryBudget;
+  Profile *profile;
+  int metric;
+  SpatialIndex pickIndex;
+  QGraphicsLineItem *root; // parent of all drawn items, NULL after clear()
+  ItemPool pool;
+
+  void indexElement(Element *element, unsigned &order);
+  void indexEdges(Element *port, unsigned &order);
+  bool markElement(Element *element, bool mark);
+  void applyHighlight(QGraphicsLineItem *line, Edge *edge);
+  void evict();
 
 public:
-  explicit DiagramScene(QComboBox *colorBox, QObject *parent = 0);
+  explicit DiagramScene(QComboBox *colorBox, QComboBox *traceBox, QObject *parent = 0);
   ~DiagramScene() {}
+  void setHighlights(Highlights *highlights) {
+    this->highlights = highlights;
+  }
+  /* model whose dataflow index is used for traces and paths, and whose region
+     layouts are evicted when over the memory budget */
+  void setModel(Model *model) {
+    this->model = model;
+  }
   void drawElement(Element *element);
+  unsigned getSummaryBudget() {
+    return summaryBudget;
+  }
+  void setSummaryBudget(unsigned budget) {
+    summaryBudget = budget;
+  }
+  quint64 getMemoryBudget() {
+    return memoryBudget;
+  }
+  void setMemoryBudget(quint64 budget) {
+    memoryBudget = budget;
+  }
+  Element *getLastElement() {
+    return lastElement;
+  }
+  void clearElement() {
+    lastElement = NULL;
+    pathSource = NULL;
+    pickIndex.clear();
+    clear();
+    pool.clear();
+    root = NULL;
+  }
+  /* topmost element or edge segment at pos, NULL if none */
+  const PickEntry *pick(const QPointF &pos) const {
+    return pickIndex.pick(pos);
+  }
+  void recolor();
+  bool showPath(Element *source, Element *target);
+  void setProfile(Profile *profile, int metric) {
+    this->profile = profile;
+    this->metric = metric;
+    retint();
+  }
+  void retint();
   void redraw() {
     if(lastElement) {
       drawElement(lastElement);
     }
   }
+  void modelChanged();
   void mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent);
   void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *mouseEvent);
+  void helpEvent(QGraphicsSceneHelpEvent *helpEvent);
+
+public slots:
+  void markRect(const QRectF &rect, bool mark);
+
+signals:
+  void elementSelected(Element *element);
+  void statusMessage(const QString &message);
 };
 
 #endif
@@ -0,0 +1,269 @@
+#include <cmath>
+#include <QElapsedTimer>
+#include <QPaintEvent>
+#include <QFontDatabase>
+
+#include "diagramview.h"
+
+static const char *causeNames[] = { "other", "pan", "zoom" };
+
+DiagramView::DiagramView(QGraphicsScene *scene) : QGraphicsView(scene) {
+  setDragMode(QGraphicsView::ScrollHandDrag);
+  viewport()->setCursor(Qt::ArrowCursor);
+
+  recording = false;
+  cause = FRAME_OTHER;
+
+  // child of the view, not the viewport, so it is not moved when the viewport scrolls
+  overlay = new QLabel(this);
+  overlay->setStyleSheet("QLabel { background-color: rgba(255, 255, 255, 200); padding: 4px; }");
+  overlay->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  overlay->hide();
+
+  tileCache = NULL;
+
+  grabbing = false;
+  zoomTimer = new QTimer(this);
+  zoomTimer->setSingleShot(true);
+  zoomTimer->setInterval(ZOOM_IDLE_DELAY);
+  connect(zoomTimer, SIGNAL(timeout()), this, SLOT(zoomFinished()));
+
+  connect(scene, SIGNAL(changed(QList<QRectF>)), this, SLOT(sceneChanged()));
+
+  rubberBand = new QRubberBand(QRubberBand::Rectangle, viewport());
+  bandMark = false;
+}
+
+void DiagramView::mousePressEvent(QMouseEvent *event) {
+  if((event->modifiers() & Qt::ShiftModifier) &&
+     ((event->button() == Qt::LeftButton) || (event->button() == Qt::RightButton))) {
+    bandOrigin = event->pos();
+    bandMark = event->button() == Qt::LeftButton;
+    rubberBand->setGeometry(QRect(bandOrigin, QSize()));
+    rubberBand->show();
+    event->accept();
+    return;
+  }
+  QGraphicsView::mousePressEvent(event);
+}
+
+void DiagramView::mouseMoveEvent(QMouseEvent *event) {
+  if(rubberBand->isVisible()) {
+    rubberBand->setGeometry(QRect(bandOrigin, event->pos()).normalized());
+    event->accept();
+    return;
+  }
+  if(event->buttons()) cause = FRAME_PAN;
+  QGraphicsView::mouseMoveEvent(event);
+}
+
+void DiagramView::mouseReleaseEvent(QMouseEvent *event) {
+  if(rubberBand->isVisible()) {
+    rubberBand->hide();
+    emit bandSelected(mapToScene(rubberBand->geometry()).boundingRect(), bandMark);
+    event->accept();
+    return;
+  }
+  QGraphicsView::mouseReleaseEvent(event);
+  viewport()->setCursor(Qt::ArrowCursor);
+}
+
+void DiagramView::paintEvent(QPaintEvent *event) {
+  if(!recording || grabbing) {
+    paintFrame(event);
+    return;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  unsigned numPainted = paintFrame(event);
+  float time = timer.nsecsElapsed() / 1e6;
+
+  // counted after the timing, the lookup is not part of the frame
+  stats[cause].add(time, numPainted ? numPainted : items(event->rect()).size());
+  cause = FRAME_OTHER;
+
+  if(overlay->isVisible()) updateOverlay();
+}
+
+/* paints the viewport from the zoom snapshot, the cached tiles or the scene, returns
+   the number of pixmaps or tiles painted, 0 if the scene items were painted */
+unsigned DiagramView::paintFrame(QPaintEvent *event) {
+  if(zoomTimer->isActive() && !zoomPixmap.isNull()) {
+    QPainter painter(viewport());
+    paintScaled(&painter, event->rect());
+    return 1;
+  }
+
+  unsigned numTiles = paintTiles(event);
+  if(!numTiles) QGraphicsView::paintEvent(event);
+  return numTiles;
+}
+
+/* paints the zoom snapshot, scaled and moved to the current transform */
+void DiagramView::paintScaled(QPainter *painter, const QRect &rect) {
+  painter->fillRect(rect, Qt::white);
+  painter->save();
+  painter->setClipRect(rect);
+  painter->setTransform(zoomTransform.inverted() * viewportTransform());
+  painter->drawPixmap(0, 0, zoomPixmap);
+  painter->restore();
+}
+
+/* scales the view, during a zoom gesture only the snapshot of the viewport taken
+   at the start is scaled, the scene is rendered once the gesture has been idle */
+void DiagramView::zoom(qreal factor) {
+  if(!zoomTimer->isActive()) {
+    // painting from tiles makes this cheap, otherwise it is one full render per gesture
+    grabbing = true;
+    zoomPixmap = viewport()->grab();
+    grabbing = false;
+    zoomTransform = viewportTransform();
+  }
+  zoomTimer->start();
+
+  cause = FRAME_ZOOM;
+  scale(factor, factor);
+}
+
+void DiagramView::zoomFinished() {
+  // with tiles, the snapshot fills in for tiles not rendered yet at the new level
+  if(!tileCache) zoomPixmap = QPixmap();
+  viewport()->update();
+}
+
+void DiagramView::sceneChanged() {
+  // the snapshot shows outdated contents, drop it unless a gesture is in progress
+  if(!zoomTimer->isActive()) zoomPixmap = QPixmap();
+}
+
+/* paints the exposed part of the viewport from cached tiles, returns the number of
+   tiles painted, or 0 if tiles can not be used and the scene must be painted directly */
+unsigned DiagramView::paintTiles(QPaintEvent *event) {
+  if(!tileCache) return 0;
+
+  // tiles exist for unrotated views at the zoom levels reachable with the zoom buttons
+  QTransform t = viewportTransform();
+  if(t.isRotating() || (t.m11() != t.m22()) || (t.m11() <= 0)) return 0;
+  int level = qRound(std::log(t.m11()) / std::log(SCALE_IN_FACTOR));
+  if(std::fabs(TileCache::levelScale(level) - t.m11()) > t.m11() * 1e-4) return 0;
+
+  int dx = qRound(t.dx());
+  int dy = qRound(t.dy());
+  QRect exposed = event->rect();
+
+  QPainter painter(viewport());
+  painter.fillRect(exposed, Qt::white);
+
+  int left = std::floor((exposed.left() - dx) / (qreal)TILE_SIZE);
+  int right = std::floor((exposed.right() - dx) / (qreal)TILE_SIZE);
+  int top = std::floor((exposed.top() - dy) / (qreal)TILE_SIZE);
+  int bottom = std::floor((exposed.bottom() - dy) / (qreal)TILE_SIZE);
+
+  unsigned numTiles = 0;
+  bool complete = true;
+  for(int y = top; y <= bottom; y++) {
+    for(int x = left; x <= right; x++) {
+      QRect rect(x * TILE_SIZE + dx, y * TILE_SIZE + dy, TILE_SIZE, TILE_SIZE);
+      const QImage *tile = tileCache->getTile(TileKey(level, x, y));
+      if(tile) {
+        painter.drawImage(rect.topLeft(), *tile);
+      } else if(!zoomPixmap.isNull()) {
+        paintScaled(&painter, rect.intersected(exposed));
+        complete = false;
+      } else {
+        painter.fillRect(rect, TILE_MISSING_COLOR);
+        complete = false;
+      }
+      numTiles++;
+    }
+  }
+
+  // the zoom snapshot is no longer needed once all tiles at the new level are there
+  if(complete) zoomPixmap = QPixmap();
+
+  return numTiles;
+}
+
+void DiagramView::setTiled(bool tiled) {
+  if(tiled && !tileCache) {
+    tileCache = new TileCache(scene(), TILE_CACHE_BUDGET, this);
+    connect(tileCache, SIGNAL(tileReady()), viewport(), SLOT(update()));
+  } else if(!tiled && tileCache) {
+    delete tileCache;
+    tileCache = NULL;
+  }
+  viewport()->update();
+}
+
+void DiagramView::updateOverlay() {
+  QString text;
+  for(unsigned i = 0; i <= FRAME_ZOOM; i++) {
+    if(i) text += "\n";
+    text += QString("%1: %2").arg(causeNames[i], -5).arg(stats[i].toString());
+  }
+  overlay->setText(text);
+  overlay->adjustSize();
+}
+
+void DiagramView::showFrameStats(bool show) {
+  recording = show;
+  for(unsigned i = 0; i <= FRAME_ZOOM; i++) {
+    stats[i].clear();
+  }
+  overlay->setVisible(show);
+  if(show) {
+    overlay->move(viewport()->geometry().topLeft());
+    overlay->raise();
+    updateOverlay();
+  }
+}
+
+QString DiagramView::replay() {
+  bool wasRecording = recording;
+  recording = true;
+
+  for(unsigned i = 0; i <= FRAME_ZOOM; i++) {
+    stats[i].clear();
+  }
+
+  QTransform oldTransform = transform();
+  int oldX = horizontalScrollBar()->value();
+  int oldY = verticalScrollBar()->value();
+
+  // pan along both axes, one synchronous repaint per step
+  QScrollBar *bars[] = { horizontalScrollBar(), verticalScrollBar() };
+  for(auto bar : bars) {
+    int range = bar->maximum() - bar->minimum();
+    for(unsigned i = 0; i <= REPLAY_PAN_STEPS; i++) {
+      cause = FRAME_PAN;
+      bar->setValue(bar->minimum() + range * i / REPLAY_PAN_STEPS);
+      viewport()->repaint();
+    }
+  }
+
+  // zoom in, out past the start, and back
+  for(unsigned i = 0; i < REPLAY_ZOOM_STEPS; i++) {
+    zoomInEvent();
+    viewport()->repaint();
+  }
+  for(unsigned i = 0; i < 2 * REPLAY_ZOOM_STEPS; i++) {
+    zoomOutEvent();
+    viewport()->repaint();
+  }
+  for(unsigned i = 0; i < REPLAY_ZOOM_STEPS; i++) {
+    zoomInEvent();
+    viewport()->repaint();
+  }
+
+  QString report = QString("pan:  %1\nzoom: %2\n").arg(stats[FRAME_PAN].toString()).arg(stats[FRAME_ZOOM].toString());
+
+  setTransform(oldTransform);
+  horizontalScrollBar()->setValue(oldX);
+  verticalScrollBar()->setValue(oldY);
+
+  recording = wasRecording;
+  if(overlay->isVisible()) updateOverlay();
+
+  return report;
+}
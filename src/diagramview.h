@@ -15,24 +15,58 @@
 #include <QMouseEvent>
 #include <QScrollBar>
 #include <QApplication>
+#include <QLabel>
+#include <QTimer>
+#include <QRubberBand>
 
 #include "rvsdg-viewer.h"
+#include "framestats.h"
+#include "tilecache.h"
+
+/* interaction a frame is attributed to */
+enum FrameCause {
+  FRAME_OTHER, FRAME_PAN, FRAME_ZOOM
+};
 
 class DiagramView : public QGraphicsView {
 
   Q_OBJECT
 
+  bool recording; // frame statistics are collected
+  FrameCause cause;
+  FrameStats stats[FRAME_ZOOM+1];
+  QLabel *overlay;
+  TileCache *tileCache; // NULL unless tiled rendering is enabled
+  QPixmap zoomPixmap;     // viewport contents when the current zoom gesture started
+  QTransform zoomTransform; // viewport transform of zoomPixmap
+  QTimer *zoomTimer;      // active during a zoom gesture
+  bool grabbing;
+  QRubberBand *rubberBand;
+  QPoint bandOrigin;
+  bool bandMark; // band started with the left button
+
+  void updateOverlay();
+  unsigned paintFrame(QPaintEvent *event);
+  unsigned paintTiles(QPaintEvent *event);
+  void paintScaled(QPainter *painter, const QRect &rect);
+  void zoom(qreal factor);
+
 protected:
-  void mouseReleaseEvent(QMouseEvent *event) {
-    QGraphicsView::mouseReleaseEvent(event);
-    viewport()->setCursor(Qt::ArrowCursor);
+  void paintEvent(QPaintEvent *event);
+  void resizeEvent(QResizeEvent *event) {
+    QGraphicsView::resizeEvent(event);
+    overlay->move(viewport()->geometry().topLeft());
   }
+  void mousePressEvent(QMouseEvent *event);
+  void mouseMoveEvent(QMouseEvent *event);
+  void mouseReleaseEvent(QMouseEvent *event);
   void wheelEvent(QWheelEvent *event) {
     if(event->modifiers() & Qt::ControlModifier) {
       if(event->delta() > 0) zoomInEvent();
       else zoomOutEvent();
       event->accept();
     } else {
+      cause = FRAME_PAN;
       QGraphicsView::wheelEvent(event);
     }
   }
@@ -49,18 +83,29 @@ protected:
   }
 
 public:
-  DiagramView(QGraphicsScene *scene) : QGraphicsView(scene) {
-    setDragMode(QGraphicsView::ScrollHandDrag);
-    viewport()->setCursor(Qt::ArrowCursor);
-  }
+  DiagramView(QGraphicsScene *scene);
+
+  /* pans across the whole scene and zooms in and out, painting every step,
+     and returns the frame statistics */
+  QString replay();
 
 public slots:
   void zoomInEvent() {
-    scale(SCALE_IN_FACTOR, SCALE_IN_FACTOR);
+    zoom(SCALE_IN_FACTOR);
   }
   void zoomOutEvent() {
-    scale(SCALE_OUT_FACTOR, SCALE_OUT_FACTOR);
+    zoom(SCALE_OUT_FACTOR);
   }
+  void showFrameStats(bool show);
+  void setTiled(bool tiled);
+
+signals:
+  /* shift-drag selected rect (scene coordinates), with the left (mark) or right button */
+  void bandSelected(const QRectF &rect, bool mark);
+
+private slots:
+  void zoomFinished();
+  void sceneChanged();
 };
 
 #endif
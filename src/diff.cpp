@@ -0,0 +1,103 @@
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#include "diff.h"
+
+static void matchElements(Element *oldEl, Element *newEl, DiffStats &stats);
+
+static void markAdded(Element *el, DiffStats &stats) {
+  el->diffState = DIFF_ADDED;
+  stats.added++;
+}
+
+static void markRemoved(Element *el, DiffStats &stats) {
+  el->diffState = DIFF_REMOVED;
+  stats.removed++;
+}
+
+/* nodes in a region are matched by id first, then by structural hash */
+static void matchRegionChildren(Element *oldEl, Element *newEl, DiffStats &stats) {
+  std::map<QString,Element*> oldById;
+  std::unordered_multimap<quint64,Element*> oldByHash;
+  std::set<Element*> matched;
+  std::vector<Element*> unmatched;
+
+  for(auto child : oldEl->children) {
+    oldById[child->id] = child;
+  }
+
+  for(auto child : newEl->children) {
+    auto it = oldById.find(child->id);
+    if((it != oldById.end()) && !matched.count(it->second)) {
+      matched.insert(it->second);
+      matchElements(it->second, child, stats);
+    } else {
+      unmatched.push_back(child);
+    }
+  }
+
+  for(auto child : oldEl->children) {
+    if(!matched.count(child)) oldByHash.insert(std::make_pair(child->hash, child));
+  }
+
+  for(auto child : unmatched) {
+    auto it = oldByHash.find(child->hash);
+    if(it != oldByHash.end()) {
+      matched.insert(it->second);
+      matchElements(it->second, child, stats);
+      oldByHash.erase(it);
+    } else {
+      markAdded(child, stats);
+    }
+  }
+
+  for(auto it : oldByHash) {
+    markRemoved(it.second, stats);
+  }
+}
+
+/* regions in a node are matched by position */
+static void matchNodeChildren(Element *oldEl, Element *newEl, DiffStats &stats) {
+  unsigned i = 0;
+  for(; (i < oldEl->children.size()) && (i < newEl->children.size()); i++) {
+    matchElements(oldEl->children[i], newEl->children[i], stats);
+  }
+  for(unsigned j = i; j < oldEl->children.size(); j++) {
+    markRemoved(oldEl->children[j], stats);
+  }
+  for(unsigned j = i; j < newEl->children.size(); j++) {
+    markAdded(newEl->children[j], stats);
+  }
+}
+
+static void matchElements(Element *oldEl, Element *newEl, DiffStats &stats) {
+  if(oldEl->hash == newEl->hash) {
+    // identical subtrees, nothing below needs to be visited
+    oldEl->diffState = DIFF_UNCHANGED;
+    newEl->diffState = DIFF_UNCHANGED;
+    return;
+  }
+
+  oldEl->diffState = DIFF_CHANGED;
+  newEl->diffState = DIFF_CHANGED;
+  if(!newEl->isRegion()) {
+    stats.changed++;
+  }
+
+  if(newEl->isRegion()) {
+    matchRegionChildren(oldEl, newEl, stats);
+  } else {
+    matchNodeChildren(oldEl, newEl, stats);
+  }
+}
+
+void diffModels(Model *oldModel, Model *newModel, DiffStats &stats) {
+  oldModel->clearDiff();
+  newModel->clearDiff();
+
+  oldModel->computeHashes();
+  newModel->computeHashes();
+
+  matchElements(oldModel->getTop(), newModel->getTop(), stats);
+}
@@ -0,0 +1,29 @@
+/******************************************************************************
+ *
+ * Structural diff of two RVSDG models
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef DIFF_H
+#define DIFF_H
+
+#include "model.h"
+
+class DiffStats {
+public:
+  unsigned added;
+  unsigned removed;
+  unsigned changed;
+
+  DiffStats() {
+    added = removed = changed = 0;
+  }
+};
+
+/* sets the diff state of the nodes and regions in both models
+   only the roots of unchanged, added and removed subtrees are marked */
+void diffModels(Model *oldModel, Model *newModel, DiffStats &stats);
+
+#endif
@@ -7,13 +7,14 @@ class Element;
 
 class Edge {
 public:
-  int color;
+  Element *source;
   Element *target;
-  unsigned zvalue;
+  unsigned number; // dense index, assigned by the model
 
-  Edge(Element *target) {
+  Edge(Element *source, Element *target) {
+    this->source = source;
     this->target = target;
-    color = -1;
+    number = 0;
   }
 };
 
@@ -4,6 +4,8 @@
 #include "element.h"
 #include "node.h"
 #include "region.h"
+#include "dataflow.h"
+#include "stats.h"
 
 #include <iostream>
 
@@ -14,11 +16,12 @@ Element::~Element() {
   for(auto it : edges) {
     delete it;
   }
+  delete stats;
 }
 
 /* recursive function that constructs the graph from XML DOM elements */
 /* the DOM element represents one child of this object */
-int Element::constructFromXml(const QDomElement &element, int treeviewRow, std::map<QString,Element*> &elements) {
+int Element::constructFromXml(const QDomElement &element, int treeviewRow, QHash<QString,Element*> &elements) {
   Element *child = this;
 
   // create child from DOM element
@@ -29,13 +32,7 @@ int Element::constructFromXml(const QDomElement &element, int treeviewRow, std::
     QString childName = element.attribute(ATTR_NAME, "");
     QString childTypeS = element.attribute(ATTR_TYPE, "");
 
-    NodeType childType = NODE;
-    if(childTypeS == "lambda") childType = LAMBDA;
-    else if(childTypeS == "gamma") childType = GAMMA;
-    else if(childTypeS == "theta") childType = THETA;
-    else if(childTypeS == "phi") childType = PHI;
-
-    child = new Node(childId, childName, childType, treeviewRow++, this);
+    child = new Node(childId, childName, parseNodeType(childTypeS), treeviewRow++, this);
     appendChild(child);
 
   } else if(tagName == TAG_REGION) {
@@ -60,3 +57,59 @@ int Element::constructFromXml(const QDomElement &element, int treeviewRow, std::
 
   return treeviewRow;
 }
+
+/* builds the list of children shown in the tree view, recursively */
+void Element::buildTreeChildren() {
+  treeChildren.clear();
+  for(auto child : children) {
+    if(!child->isSimpleNode()) {
+      child->treeviewRow = treeChildren.size();
+      treeChildren.push_back(child);
+    }
+    child->buildTreeChildren();
+  }
+}
+
+void Element::appendFlowLinks(std::vector<FlowLink> &links, bool forward) {
+  if(forward) {
+    for(auto edge : edges) {
+      links.push_back(FlowLink(number, edge->target->number, edge));
+    }
+  } else {
+    for(auto edge : inEdges) {
+      links.push_back(FlowLink(edge->source->number, number, edge));
+    }
+  }
+}
+
+void Element::computeHash() {
+  quint64 h = children.size();
+  for(auto child : children) {
+    h = hashCombine(h, child->hash);
+  }
+  hash = h;
+}
+
+void Element::computeStats() {
+  if(!stats) stats = new SubtreeStats;
+  stats->clear();
+  for(auto child : children) {
+    stats->add(*child->stats);
+  }
+}
+
+bool Element::getDiffColor(QColor &color) {
+  switch(getDiffState()) {
+    case DIFF_ADDED:
+      color = DIFF_ADDED_COLOR;
+      return true;
+    case DIFF_REMOVED:
+      color = DIFF_REMOVED_COLOR;
+      return true;
+    case DIFF_CHANGED:
+      color = DIFF_CHANGED_COLOR;
+      return true;
+    default:
+      return false;
+  }
+}
@@ -13,37 +13,60 @@
 #include <vector>
 #include <string>
 #include <QDomDocument>
+#include <QHash>
 #include <QAbstractItemModel>
 #include <QModelIndex>
 #include <QGraphicsPolygonItem>
 
 #include "rvsdg-viewer.h"
 #include "linesegment.h"
+#include "itempool.h"
 
 class Edge;
+class FlowLink;
+class SubtreeStats;
+
+enum DiffState {
+  DIFF_NONE, DIFF_UNCHANGED, DIFF_ADDED, DIFF_REMOVED, DIFF_CHANGED
+};
+
+inline quint64 hashCombine(quint64 hash, quint64 value) {
+  return (hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2))) * 0x100000001b3ULL;
+}
 
 class Element {
+  friend class MemoryReport;
 
 protected:
-  unsigned row;
-  unsigned column;
   unsigned x;
   unsigned y;
   std::vector<LineSegment> lineSegments;
+  QGraphicsPolygonItem *baseItem;
 
   void init(QString id) {
     this->id = id;
     this->parent = NULL;
+    this->baseItem = NULL;
     this->treeviewRow = 0;
-    row = column = x = y = 0;
+    this->number = 0;
+    this->hash = 0;
+    this->diffState = DIFF_NONE;
+    this->stats = NULL;
+    x = y = 0;
   }
 
 public:
   QString id;
   Element *parent;
-  unsigned treeviewRow;
+  unsigned treeviewRow; // row in parent->treeChildren
+  unsigned number; // dense index, assigned by the model
   std::vector<Element*> children;
-  std::vector<Edge*> edges;
+  std::vector<Element*> treeChildren; // children shown in the tree view
+  quint64 hash; // structural hash of this subtree, ignoring ids
+  DiffState diffState;
+  SubtreeStats *stats; // NULL for ports
+  std::vector<Edge*> edges;   // outgoing edges, owned by this element
+  std::vector<Edge*> inEdges; // incoming edges
 
   //---------------------------------------------------------------------------
   // constructors and destructor
@@ -61,7 +84,7 @@ public:
   //---------------------------------------------------------------------------
   // building the graph
 
-  int constructFromXml(const QDomElement &element, int treeviewRow, std::map<QString,Element*> &elements);
+  int constructFromXml(const QDomElement &element, int treeviewRow, QHash<QString,Element*> &elements);
 
   virtual Element *parseXmlElement(QString tagName, QString childId) {
     Q_UNUSED(tagName);
@@ -73,10 +96,16 @@ public:
     edges.push_back(e);
   }
 
+  void appendInEdge(Edge *e) {
+    inEdges.push_back(e);
+  }
+
   void appendChild(Element *e) {
     children.push_back(e);
   }
 
+  void buildTreeChildren();
+
   //---------------------------------------------------------------------------
   // graph information
 
@@ -92,11 +121,6 @@ public:
     return edges[n];
   }
 
-  virtual Edge *getEdge(unsigned n, Element **source) {
-    *source = this;
-    return edges[n];
-  }
-
   virtual void setLineSegments(unsigned n, std::vector<LineSegment>lines) {
     Q_UNUSED(n);
     lineSegments.insert(lineSegments.end(), lines.begin(), lines.end());
@@ -114,10 +138,40 @@ public:
     return false;
   }
 
+  virtual bool isRegion() {
+    return false;
+  }
+
   virtual QString getTypeName() {
     return QString("");
   }
 
+  virtual QString getName() {
+    return QString("");
+  }
+
+  /* appends the ports (inputs, outputs, arguments or results) of this element */
+  virtual void getPorts(std::vector<Element*> &ports) {
+    Q_UNUSED(ports);
+  }
+
+  /* appends the dataflow links going out of this element, taking the edges
+     from the outgoing edges when forward and from the incoming edges otherwise */
+  virtual void appendFlowLinks(std::vector<FlowLink> &links, bool forward);
+
+  /* computes hash, assuming the hashes of all children are up to date */
+  virtual void computeHash();
+
+  /* computes stats, assuming the stats of all children are up to date */
+  virtual void computeStats();
+
+  /* diff state, subtrees inherit the state of unchanged, added and removed parents */
+  DiffState getDiffState() {
+    if((diffState == DIFF_NONE) && parent) return parent->getDiffState();
+    return diffState;
+  }
+  bool getDiffColor(QColor &color);
+
   //---------------------------------------------------------------------------
   // graphical information, used when drawing
 
@@ -125,16 +179,6 @@ public:
     this->x = x;
     this->y = y;
   }
-  void setRowCol(unsigned r, unsigned c) {
-    row = r;
-    column = c;
-  }
-  virtual unsigned getRow() {
-    return row;
-  }
-  virtual unsigned getColumn() {
-    return column;
-  }
   virtual unsigned getX() {
     return x;
   }
@@ -147,6 +191,10 @@ public:
   virtual unsigned getHeight() {
     return 0;
   }
+  /* the item created by the last call to appendItems, NULL if none */
+  QGraphicsItem *getBaseItem() {
+    return baseItem;
+  }
   /* appends QGraphicsItems representing this element to the given parent */
   virtual void appendItems(QGraphicsItem *parent) {
     Q_UNUSED(parent);
@@ -154,13 +202,12 @@ public:
   virtual void clearLineSegments() {
     lineSegments.clear();
   }
-  virtual void clearColors() {
-    for(auto edge : edges) {
-      edge->color = -1;
-    }
-    for(auto child : children) {
-      child->clearColors();
-    }
+  /* frees the line segments of an evicted layout */
+  void releaseLineSegments() {
+    std::vector<LineSegment>().swap(lineSegments);
+  }
+  quint64 getLineSegmentMemory() {
+    return lineSegments.capacity() * sizeof(LineSegment);
   }
 };
 
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <cmath>
+
+#include "framestats.h"
+
+void FrameStats::add(float time, unsigned numItems) {
+  if(times.size() < FRAME_STATS_WINDOW) {
+    times.push_back(time);
+    items.push_back(numItems);
+  } else {
+    times[next] = time;
+    items[next] = numItems;
+    next = (next + 1) % FRAME_STATS_WINDOW;
+  }
+}
+
+void FrameStats::clear() {
+  times.clear();
+  items.clear();
+  next = 0;
+}
+
+float FrameStats::percentile(float p) const {
+  if(times.empty()) return 0;
+
+  // nearest rank
+  std::vector<float> sorted(times);
+  unsigned rank = std::ceil(p / 100 * sorted.size());
+  unsigned n = rank ? std::min(rank, (unsigned)sorted.size()) - 1 : 0;
+  std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+  return sorted[n];
+}
+
+QString FrameStats::toString() const {
+  if(times.empty()) return QString("no frames");
+
+  quint64 totalItems = 0;
+  for(auto n : items) {
+    totalItems += n;
+  }
+
+  return QString("%1 frames, p50 %2 ms, p95 %3 ms, p99 %4 ms, %5 items/frame")
+    .arg(times.size())
+    .arg(percentile(50), 0, 'f', 1)
+    .arg(percentile(95), 0, 'f', 1)
+    .arg(percentile(99), 0, 'f', 1)
+    .arg(totalItems / items.size());
+}
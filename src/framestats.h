@@ -0,0 +1,40 @@
+/******************************************************************************
+ *
+ * Frame time statistics for the diagram view
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <vector>
+#include <QString>
+
+#include "rvsdg-viewer.h"
+
+/* render times and painted item counts of the last FRAME_STATS_WINDOW frames */
+class FrameStats {
+  std::vector<float> times; // ms
+  std::vector<unsigned> items;
+  unsigned next; // ring buffer position, once the window is full
+
+public:
+  FrameStats() {
+    next = 0;
+  }
+
+  void add(float time, unsigned numItems);
+  void clear();
+  unsigned size() const {
+    return times.size();
+  }
+
+  /* frame time at the given percentile (0..100), 0 if no frames */
+  float percentile(float p) const;
+
+  QString toString() const;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "highlight.h"
+#include "rvsdg-viewer.h"
+
+Highlights::Highlights() : path("Path", PATH_COLOR) {
+  QColor colors[] = EDGE_COLORS;
+  QString names[] = COLOR_NAMES;
+
+  for(unsigned i = 0; i < sizeof(colors)/sizeof(colors[0]); i++) {
+    layers.push_back(HighlightLayer(names[i], colors[i]));
+  }
+
+  stamp = 0;
+  overlapOnly = false;
+}
+
+void Highlights::clearAll() {
+  for(unsigned i = 0; i < layers.size(); i++) {
+    clear(i);
+  }
+  clearPath();
+  overlap.release();
+}
+
+static void moveBit(Bitset &set, unsigned from, unsigned to) {
+  if(set.contains(from)) set.insert(to);
+  else set.remove(to);
+  set.remove(from);
+}
+
+void Highlights::moveEdge(unsigned from, unsigned to) {
+  for(auto &layer : layers) {
+    moveBit(layer.edges, from, to);
+  }
+  moveBit(path.edges, from, to);
+}
+
+void Highlights::copySettings(const Highlights &other) {
+  for(unsigned i = 0; i < layers.size(); i++) {
+    layers[i].visible = other.layers[i].visible;
+    layers[i].stamp = other.layers[i].stamp;
+  }
+  path.visible = other.path.visible;
+  stamp = other.stamp;
+  overlapOnly = other.overlapOnly;
+}
+
+void Highlights::setOverlapOnly(bool overlapOnly) {
+  this->overlapOnly = overlapOnly;
+  update();
+}
+
+void Highlights::update() {
+  overlap.release();
+  if(!overlapOnly) return;
+
+  bool first = true;
+  for(auto &layer : layers) {
+    if(!layer.visible) continue;
+    if(first) overlap = layer.edges;
+    else overlap.intersect(layer.edges);
+    first = false;
+  }
+}
+
+void Highlights::setVisible(unsigned layer, bool visible) {
+  layers[layer].visible = visible;
+  update();
+}
+
+bool Highlights::getColor(unsigned edge, QColor &color, unsigned &zvalue) const {
+  if(path.visible && path.edges.contains(edge)) {
+    color = path.color;
+    zvalue = stamp + 1;
+    return true;
+  }
+
+  if(overlapOnly && !overlap.contains(edge)) return false;
+
+  const HighlightLayer *top = NULL;
+  for(auto &layer : layers) {
+    if(layer.visible && layer.edges.contains(edge) && (!top || (layer.stamp > top->stamp))) {
+      top = &layer;
+    }
+  }
+  if(!top) return false;
+
+  color = top->color;
+  zvalue = top->stamp;
+  return true;
+}
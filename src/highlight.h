@@ -0,0 +1,101 @@
+/******************************************************************************
+ *
+ * Highlight layers, sets of edges shown in a color
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef HIGHLIGHT_H
+#define HIGHLIGHT_H
+
+#include <vector>
+#include <QColor>
+#include <QString>
+
+#include "bitset.h"
+
+class HighlightLayer {
+public:
+  QString name;
+  QColor color;
+  bool visible;
+  unsigned stamp; // last time edges were added, the most recent layer is on top
+  Bitset edges;   // by edge number
+
+  HighlightLayer(const QString &name, const QColor &color) {
+    this->name = name;
+    this->color = color;
+    visible = true;
+    stamp = 0;
+  }
+};
+
+/* one layer per edge color, each independent of the others */
+class Highlights {
+  std::vector<HighlightLayer> layers;
+  HighlightLayer path; // shortest path between two elements, drawn above the layers
+  unsigned stamp;
+  bool overlapOnly;
+  Bitset overlap; // edges in all visible layers, valid when overlapOnly
+
+public:
+  Highlights();
+
+  unsigned size() const {
+    return layers.size();
+  }
+  HighlightLayer &getLayer(unsigned n) {
+    return layers[n];
+  }
+
+  /* adds edges to layer, on top of the other layers
+     returns false if the layer already was on top */
+  bool touch(unsigned layer) {
+    if(stamp && (layers[layer].stamp == stamp)) return false;
+    layers[layer].stamp = ++stamp;
+    return true;
+  }
+  void mark(unsigned layer, unsigned edge) {
+    layers[layer].edges.insert(edge);
+  }
+  void unmark(unsigned layer, unsigned edge) {
+    layers[layer].edges.remove(edge);
+  }
+
+  void clear(unsigned layer) {
+    layers[layer].edges.release();
+  }
+  void clearAll();
+
+  /* replaces the path, which is not part of the overlap */
+  void clearPath() {
+    path.edges.release();
+  }
+  void markPath(unsigned edge) {
+    path.edges.insert(edge);
+  }
+
+  /* gives edge number to the edge numbered from, when the model renumbers a removed
+     edge's slot, the old membership of to is dropped */
+  void moveEdge(unsigned from, unsigned to);
+
+  /* copies visibility, stacking order and overlap mode, but not the edges */
+  void copySettings(const Highlights &other);
+
+  /* when set, only edges present in every visible layer are shown */
+  void setOverlapOnly(bool overlapOnly);
+  void setVisible(unsigned layer, bool visible);
+  bool getOverlapOnly() const {
+    return overlapOnly;
+  }
+
+  /* recomputes the overlap of the visible layers, after edges have been marked */
+  void update();
+
+  /* color and stacking order of an edge, from the topmost visible layer
+     containing it, returns false if the edge is not highlighted */
+  bool getColor(unsigned edge, QColor &color, unsigned &zvalue) const;
+};
+
+#endif
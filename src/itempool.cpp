@@ -0,0 +1,142 @@
+#include "itempool.h"
+
+ItemPool *ItemPool::active = NULL;
+
+void ItemPool::begin() {
+  cursors.clear();
+  reused.clear();
+  active = this;
+}
+
+void ItemPool::hide(QGraphicsItem *item) {
+  item->setVisible(false);
+  item->setData(0, QVariant());
+  item->setData(1, QVariant());
+
+  // items still unused since an earlier draw keep their place
+  if(!idlePos.contains(item)) {
+    idle.push_front(item);
+    idlePos[item] = idle.begin();
+  }
+}
+
+void ItemPool::unhide(QGraphicsItem *item) {
+  auto it = idlePos.find(item);
+  if(it != idlePos.end()) {
+    idle.erase(*it);
+    idlePos.erase(it);
+  }
+}
+
+/* removes item and its descendants from the idle list */
+void ItemPool::forget(QGraphicsItem *item) {
+  unhide(item);
+  for(auto child : item->childItems()) {
+    forget(child);
+  }
+}
+
+void ItemPool::end() {
+  for(auto &cursor : cursors) {
+    for(auto item : cursor.skipped + cursor.children.mid(cursor.next)) {
+      hide(item);
+    }
+  }
+
+  // reused items that got no children this time, e.g. a node box reused for a port
+  for(auto item : reused) {
+    if(!cursors.contains(item)) {
+      for(auto child : item->childItems()) {
+        hide(child);
+      }
+    }
+  }
+
+  cursors.clear();
+  reused.clear();
+  active = NULL;
+}
+
+void ItemPool::trim(unsigned maxIdle) {
+  while(idle.size() > maxIdle) {
+    QGraphicsItem *item = idle.back();
+    forget(item);
+    delete item;
+  }
+}
+
+/* next unused child of parent with the given type, NULL if there is none */
+QGraphicsItem *ItemPool::take(QGraphicsItem *parent, int type) {
+  if(!parent) return NULL;
+
+  auto it = cursors.find(parent);
+  if(it == cursors.end()) {
+    it = cursors.insert(parent, Cursor());
+    it->children = parent->childItems();
+  }
+
+  Cursor &cursor = *it;
+
+  // items skipped earlier are only reused if the draw has changed shape
+  for(int i = 0; i < cursor.skipped.size(); i++) {
+    if(cursor.skipped[i]->type() == type) {
+      reused.push_back(cursor.skipped[i]);
+      unhide(cursor.skipped[i]);
+      return cursor.skipped.takeAt(i);
+    }
+  }
+
+  while(cursor.next < cursor.children.size()) {
+    QGraphicsItem *item = cursor.children[cursor.next++];
+    if(item->type() == type) {
+      reused.push_back(item);
+      unhide(item);
+      return item;
+    }
+    cursor.skipped.push_back(item);
+  }
+
+  return NULL;
+}
+
+static void resetItem(QGraphicsItem *item) {
+  item->setPos(0, 0);
+  item->setZValue(0);
+  item->setData(0, QVariant());
+  item->setData(1, QVariant());
+  item->setVisible(true);
+}
+
+QGraphicsPolygonItem *ItemPool::polygon(QGraphicsItem *parent) {
+  return polygon(QPolygonF(), parent);
+}
+
+QGraphicsPolygonItem *ItemPool::polygon(const QPolygonF &polygon, QGraphicsItem *parent) {
+  QGraphicsPolygonItem *item = static_cast<QGraphicsPolygonItem*>(active ? active->take(parent, QGraphicsPolygonItem::Type) : NULL);
+  if(!item) return new QGraphicsPolygonItem(polygon, parent);
+
+  resetItem(item);
+  item->setPolygon(polygon);
+  item->setPen(QPen());
+  item->setBrush(QBrush());
+  return item;
+}
+
+QGraphicsTextItem *ItemPool::text(const QString &text, QGraphicsItem *parent) {
+  QGraphicsTextItem *item = static_cast<QGraphicsTextItem*>(active ? active->take(parent, QGraphicsTextItem::Type) : NULL);
+  if(!item) return new QGraphicsTextItem(text, parent);
+
+  resetItem(item);
+  if(item->toPlainText() != text) item->setPlainText(text);
+  return item;
+}
+
+QGraphicsLineItem *ItemPool::line(qreal x1, qreal y1, qreal x2, qreal y2, QGraphicsItem *parent) {
+  QGraphicsLineItem *item = static_cast<QGraphicsLineItem*>(active ? active->take(parent, QGraphicsLineItem::Type) : NULL);
+  if(!item) return new QGraphicsLineItem(x1, y1, x2, y2, parent);
+
+  resetItem(item);
+  item->setLine(x1, y1, x2, y2);
+  item->setPen(QPen());
+  return item;
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * Reuse of graphics items across redraws
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef ITEMPOOL_H
+#define ITEMPOOL_H
+
+#include <list>
+#include <QHash>
+#include <QList>
+#include <QGraphicsItem>
+#include <QGraphicsPolygonItem>
+#include <QGraphicsTextItem>
+#include <QGraphicsLineItem>
+
+/* hands out the items created under a parent by the previous draw, in the
+   same order and of the same type, before creating new ones
+   this keeps the sibling stacking order and avoids deleting and reinserting
+   items in the scene when an unchanged subtree is drawn again */
+class ItemPool {
+  class Cursor {
+  public:
+    QList<QGraphicsItem*> children; // children of the parent when the draw started
+    int next;                        // first child not examined yet
+    QList<QGraphicsItem*> skipped;   // examined, but of another type
+
+    Cursor() {
+      next = 0;
+    }
+  };
+
+  QHash<QGraphicsItem*,Cursor> cursors;
+  QList<QGraphicsItem*> reused;
+
+  // hidden items kept for reuse, most recently hidden first
+  std::list<QGraphicsItem*> idle;
+  QHash<QGraphicsItem*,std::list<QGraphicsItem*>::iterator> idlePos;
+
+  QGraphicsItem *take(QGraphicsItem *parent, int type);
+  void hide(QGraphicsItem *item);
+  void unhide(QGraphicsItem *item);
+  void forget(QGraphicsItem *item);
+
+  static ItemPool *active; // pool used by the element appendItems functions
+
+public:
+  /* starts a draw, items are taken from this pool until end() */
+  void begin();
+  /* hides the items that were not reused */
+  void end();
+
+  /* deletes the least recently hidden items until at most maxIdle are left */
+  void trim(unsigned maxIdle);
+  unsigned getNumIdle() const {
+    return idle.size();
+  }
+  /* forgets all items, after they have been deleted with the scene */
+  void clear() {
+    idle.clear();
+    idlePos.clear();
+  }
+
+  static QGraphicsPolygonItem *polygon(QGraphicsItem *parent);
+  static QGraphicsPolygonItem *polygon(const QPolygonF &polygon, QGraphicsItem *parent);
+  static QGraphicsTextItem *text(const QString &text, QGraphicsItem *parent);
+  static QGraphicsLineItem *line(qreal x1, qreal y1, qreal x2, qreal y2, QGraphicsItem *parent);
+};
+
+#endif
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ * Framing of live graph updates sent to the viewer over a local socket
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef LIVEFRAME_H
+#define LIVEFRAME_H
+
+#include <QByteArray>
+#include <QString>
+#include <QDataStream>
+#include <QtEndian>
+
+#include "rvsdg-viewer.h"
+
+/* A stream is a sequence of frames, each a big endian quint32 payload size
+   followed by the payload: a quint8 op and the op's fields, strings as UTF-8
+   byte arrays in QDataStream encoding.
+
+     LIVE_SNAPSHOT     xml                 replaces the whole graph
+     LIVE_ADD          parent id, xml      adds a node, region, port or edge element
+                                           (with its subtree) to parent, "" is the root
+     LIVE_REMOVE       id                  removes an element, its subtree and its edges
+     LIVE_MODIFY       id, key, value      sets the name or type attribute of a node
+     LIVE_ADD_EDGE     source, target      adds an edge
+     LIVE_REMOVE_EDGE  source, target      removes an edge
+     LIVE_COMMIT                           shows the updates received so far
+
+   Updates not followed by a commit are shown after LIVE_BATCH_DELAY ms. */
+
+enum LiveOp {
+  LIVE_SNAPSHOT = 1, LIVE_ADD, LIVE_REMOVE, LIVE_MODIFY, LIVE_ADD_EDGE, LIVE_REMOVE_EDGE, LIVE_COMMIT
+};
+
+class LiveFrame {
+public:
+  quint8 op;
+  QString id;     // element, parent (LIVE_ADD) or edge source
+  QString key;    // attribute (LIVE_MODIFY) or edge target
+  QString value;  // attribute value (LIVE_MODIFY)
+  QByteArray xml; // LIVE_SNAPSHOT and LIVE_ADD
+
+  LiveFrame(quint8 op = LIVE_COMMIT) {
+    this->op = op;
+  }
+
+  /* size prefixed frame, ready to be written to the socket */
+  QByteArray encode() const {
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << op;
+    switch(op) {
+      case LIVE_SNAPSHOT:
+        stream << xml;
+        break;
+      case LIVE_ADD:
+        stream << id.toUtf8() << xml;
+        break;
+      case LIVE_REMOVE:
+        stream << id.toUtf8();
+        break;
+      case LIVE_MODIFY:
+        stream << id.toUtf8() << key.toUtf8() << value.toUtf8();
+        break;
+      case LIVE_ADD_EDGE:
+      case LIVE_REMOVE_EDGE:
+        stream << id.toUtf8() << key.toUtf8();
+        break;
+    }
+
+    QByteArray frame(sizeof(quint32), 0);
+    qToBigEndian<quint32>(payload.size(), (uchar*)frame.data());
+    return frame + payload;
+  }
+
+  /* decodes a payload, returns false if it is malformed */
+  bool decode(const QByteArray &payload) {
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray a, b, c;
+    stream >> op;
+    switch(op) {
+      case LIVE_SNAPSHOT:
+        stream >> xml;
+        break;
+      case LIVE_ADD:
+        stream >> a >> xml;
+        break;
+      case LIVE_REMOVE:
+        stream >> a;
+        break;
+      case LIVE_MODIFY:
+        stream >> a >> b >> c;
+        break;
+      case LIVE_ADD_EDGE:
+      case LIVE_REMOVE_EDGE:
+        stream >> a >> b;
+        break;
+      case LIVE_COMMIT:
+        break;
+      default:
+        return false;
+    }
+    id = QString::fromUtf8(a);
+    key = QString::fromUtf8(b);
+    value = QString::fromUtf8(c);
+
+    return stream.status() == QDataStream::Ok;
+  }
+
+  /* removes the payload of the first complete frame from buffer,
+     returns false if there is none, sets error if the size is out of range */
+  static bool take(QByteArray &buffer, QByteArray &payload, bool &error) {
+    error = false;
+    if(buffer.size() < (int)sizeof(quint32)) return false;
+
+    quint32 size = qFromBigEndian<quint32>((const uchar*)buffer.constData());
+    if(size > LIVE_MAX_FRAME) {
+      error = true;
+      return false;
+    }
+    if((quint32)buffer.size() < sizeof(quint32) + size) return false;
+
+    payload = buffer.mid(sizeof(quint32), size);
+    buffer.remove(0, sizeof(quint32) + size);
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include <QCoreApplication>
+#include <QDomDocument>
+#include <QtConcurrent>
+
+#include "livestream.h"
+#include "model.h"
+
+/* model of a whole graph, NULL if it is not a valid RVSDG */
+static Model *buildModel(const QByteArray &xml) {
+  QDomDocument doc;
+  if(!doc.setContent(xml)) return NULL;
+
+  try {
+    return new Model(doc);
+  } catch (std::exception &e) {
+    return NULL;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LiveServer
+
+LiveServer::LiveServer(QObject *parent) : QObject(parent) {
+  model = NULL;
+  batchSize = 0;
+  busy = false;
+
+  server = new QLocalServer(this);
+  connect(server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+
+  batchTimer = new QTimer(this);
+  batchTimer->setSingleShot(true);
+  batchTimer->setInterval(LIVE_BATCH_DELAY);
+  connect(batchTimer, SIGNAL(timeout()), this, SLOT(applyBatch()));
+
+  watcher = new QFutureWatcher<Model*>(this);
+  connect(watcher, SIGNAL(finished()), this, SLOT(batchFinished()));
+}
+
+LiveServer::~LiveServer() {
+  // a model built but not yet handed over by batchFinished()
+  if(busy) {
+    watcher->waitForFinished();
+    delete watcher->result();
+  }
+}
+
+bool LiveServer::listen(const QString &name) {
+  // a socket left behind by a crashed viewer would make listen fail
+  QLocalServer::removeServer(name);
+  return server->listen(name);
+}
+
+void LiveServer::newConnection() {
+  while(server->hasPendingConnections()) {
+    QLocalSocket *socket = server->nextPendingConnection();
+    buffers[socket] = QByteArray();
+    connect(socket, SIGNAL(readyRead()), this, SLOT(readFrames()));
+    connect(socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+  }
+}
+
+void LiveServer::readFrames() {
+  QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+  if(!socket || !buffers.contains(socket)) return;
+
+  QByteArray &buffer = buffers[socket];
+  buffer.append(socket->readAll());
+
+  bool commit = false;
+  bool error = false;
+  QByteArray payload;
+  while(LiveFrame::take(buffer, payload, error)) {
+    if(payload.size() && ((quint8)payload[0] == LIVE_COMMIT)) commit = true;
+    pending.append(payload);
+  }
+
+  if(error) {
+    // not a frame stream, drop the client
+    buffers.remove(socket);
+    socket->abort();
+  }
+
+  if(commit) {
+    applyBatch();
+  } else if(!pending.isEmpty() && !batchTimer->isActive()) {
+    batchTimer->start();
+  }
+}
+
+void LiveServer::disconnected() {
+  QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+  if(!socket) return;
+
+  buffers.remove(socket);
+  socket->deleteLater();
+
+  applyBatch();
+}
+
+bool LiveServer::apply(const LiveFrame &frame) {
+  switch(frame.op) {
+    case LIVE_ADD: {
+      QDomDocument fragment;
+      if(!fragment.setContent(frame.xml)) return false;
+      return model->addElement(frame.id, fragment.documentElement());
+    }
+
+    case LIVE_REMOVE:
+      return model->removeElement(frame.id);
+
+    case LIVE_MODIFY:
+      return model->modifyElement(frame.id, frame.key, frame.value);
+
+    case LIVE_ADD_EDGE:
+      return model->addEdge(frame.id, frame.key);
+
+    case LIVE_REMOVE_EDGE:
+      return model->removeEdge(frame.id, frame.key);
+
+    case LIVE_COMMIT:
+      return true;
+  }
+
+  return false;
+}
+
+/* applies the pending frames to the model, or builds a model of the last snapshot
+   among them in a worker thread, frames arriving meanwhile make up the next batch
+   the worker may be done before its finished() signal is handled, so busy is cleared
+   by batchFinished() and not by the worker */
+void LiveServer::applyBatch() {
+  batchTimer->stop();
+  if(busy || pending.isEmpty()) return;
+
+  // a snapshot replaces the graph, so the frames before it need not be applied
+  int snapshot = -1;
+  for(int i = pending.size() - 1; (i >= 0) && (snapshot < 0); i--) {
+    if(pending[i].size() && ((quint8)pending[i][0] == LIVE_SNAPSHOT)) snapshot = i;
+  }
+
+  unsigned rejected = 0;
+  if(snapshot >= 0) {
+    LiveFrame frame;
+    bool ok = frame.decode(pending[snapshot]);
+    batchSize = snapshot + 1;
+    pending = pending.mid(snapshot + 1);
+
+    if(!ok) {
+      rejected++;
+    } else {
+      busy = true;
+      QByteArray xml = frame.xml;
+      watcher->setFuture(QtConcurrent::run([xml]() {
+        Model *model = buildModel(xml);
+        if(model) model->moveToThread(QCoreApplication::instance()->thread());
+        return model;
+      }));
+      return;
+    }
+  }
+
+  if(!model) {
+    // the first updates go into an empty graph
+    model = buildModel("<rvsdg/>");
+    emit modelReady(model, 0, 0);
+  }
+
+  QList<QByteArray> batch;
+  batch.swap(pending);
+
+  for(auto &payload : batch) {
+    LiveFrame frame;
+    if(!frame.decode(payload) || !apply(frame)) rejected++;
+  }
+  model->commitChanges();
+
+  emit modelUpdated(batch.size(), rejected);
+}
+
+void LiveServer::batchFinished() {
+  busy = false;
+  Model *snapshot = watcher->result();
+
+  if(snapshot) {
+    model = snapshot;
+    emit modelReady(snapshot, batchSize, 0);
+  }
+
+  if(!pending.isEmpty()) applyBatch();
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * Live graph streaming, receives snapshots and updates over a local socket
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef LIVESTREAM_H
+#define LIVESTREAM_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include "liveframe.h"
+
+class Model;
+
+/* Updates are applied in batches to the model shown, in place, so a batch only
+   costs what it touches. Snapshots replace the model and are built in a
+   worker thread, updates arriving meanwhile wait for the snapshot. */
+class LiveServer : public QObject {
+  Q_OBJECT
+
+  QLocalServer *server;
+  QHash<QLocalSocket*,QByteArray> buffers; // received data not yet framed, per client
+  QList<QByteArray> pending;                // frames not yet applied
+  QTimer *batchTimer;
+  QFutureWatcher<Model*> *watcher;          // builds snapshots
+  Model *model;                             // updates are applied to this, owned by the receiver
+  unsigned batchSize;                       // frames up to the snapshot being built
+  bool busy;                                // from applyBatch() until batchFinished() has run
+
+  bool apply(const LiveFrame &frame);
+
+public:
+  LiveServer(QObject *parent = 0);
+  ~LiveServer();
+
+  bool listen(const QString &name);
+  QString errorString() {
+    return server->errorString();
+  }
+  QString serverName() {
+    return server->fullServerName();
+  }
+
+  /* the model shown, must be set whenever the receiver replaces it */
+  void setModel(Model *model) {
+    this->model = model;
+  }
+
+signals:
+  /* a new graph from a snapshot, or the empty graph the first updates go into,
+     owned by the receiver */
+  void modelReady(Model *model, unsigned frames, unsigned rejected);
+  /* a batch of updates has been applied to the model */
+  void modelUpdated(unsigned frames, unsigned rejected);
+
+private slots:
+  void newConnection();
+  void readFrames();
+  void disconnected();
+  void applyBatch();
+  void batchFinished();
+};
+
+#endif
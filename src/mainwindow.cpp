@@ -1,12 +1,21 @@
 #include <QDomDocument>
+#include <QtConcurrent>
+#include <climits>
 
 #include "mainwindow.h"
 #include "diagramview.h"
+#include "diff.h"
+#include "timeline.h"
+#include "region.h"
+#include "stats.h"
+#include "memreport.h"
+#include "livestream.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
 QColor edgeColors[] = EDGE_COLORS;
 QString colorNames[] = COLOR_NAMES;
+QString traceNames[] = TRACE_NAMES;
 
 MainWindow::MainWindow() {
   init();
@@ -17,6 +26,11 @@ MainWindow::MainWindow(const QString &fileName) {
   loadFile(fileName);
 }
 
+MainWindow::MainWindow(const QString &fileName, Model *model) {
+  init();
+  openModel(fileName, model);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void MainWindow::closeEvent(QCloseEvent *event) {
@@ -24,7 +38,7 @@ void MainWindow::closeEvent(QCloseEvent *event) {
 }
 
 void MainWindow::open() {
-  QString fileName = QFileDialog::getOpenFileName(this, tr("Open File"), QString(), tr("RVSDG files (*.rvsdg)"));
+  QString fileName = QFileDialog::getOpenFileName(this, tr("Open File"), QString(), tr(FILE_FILTER));
   if(!fileName.isNull()) loadFile(fileName);
   graphicsView->viewport()->setCursor(Qt::ArrowCursor);
 }
@@ -38,34 +52,177 @@ void MainWindow::about() {
 void MainWindow::regionClicked(const QModelIndex &index) {
   Element *el = static_cast<Element*>(index.internalPointer());
   scene->drawElement(el);
+  showMetrics(el);
+}
+
+/* shows the precomputed subtree statistics of the element, or of the node owning a port */
+void MainWindow::showMetrics(Element *element) {
+  metricsView->clear();
+
+  if(!element->stats) element = element->getVertex();
+  if(!element->stats) element = element->parent;
+  if(!element || !element->stats) return;
+
+  SubtreeStats *stats = element->stats;
+
+  QList<QTreeWidgetItem*> items;
+  items << new QTreeWidgetItem(QStringList() << tr("Element") << element->getTypeName() + " " + element->id);
+  items << new QTreeWidgetItem(QStringList() << tr("Nodes") << QString::number(stats->getNumNodes()));
+  items << new QTreeWidgetItem(QStringList() << tr("  Simple") << QString::number(stats->nodes[NODE]));
+  items << new QTreeWidgetItem(QStringList() << tr("  Lambda") << QString::number(stats->nodes[LAMBDA]));
+  items << new QTreeWidgetItem(QStringList() << tr("  Gamma") << QString::number(stats->nodes[GAMMA]));
+  items << new QTreeWidgetItem(QStringList() << tr("  Theta") << QString::number(stats->nodes[THETA]));
+  items << new QTreeWidgetItem(QStringList() << tr("  Phi") << QString::number(stats->nodes[PHI]));
+  items << new QTreeWidgetItem(QStringList() << tr("Edges") << QString::number(stats->edges));
+  items << new QTreeWidgetItem(QStringList() << tr("Nesting depth") << QString::number(stats->depth));
+  items << new QTreeWidgetItem(QStringList() << tr("Widest layer") << QString::number(stats->widestLayer));
+  items << new QTreeWidgetItem(QStringList() << tr("Max fanout") << QString::number(stats->maxFanout));
+  items << new QTreeWidgetItem(QStringList() << tr("Longest path") << QString::number(stats->longestPath));
+  metricsView->addTopLevelItems(items);
+}
+
+void MainWindow::searchEvent(const QString &pattern) {
+  searchResults->clear();
+
+  if(!searchIndex) {
+    // dropped by a live update
+    if(rvsdgModel && !pattern.isEmpty()) buildSearchIndex();
+    return;
+  }
+
+  std::vector<Element*> hits;
+  searchIndex->search(pattern, SEARCH_MAX_HITS, hits);
+
+  for(auto hit : hits) {
+    QString text = hit->getTypeName() + " " + hit->id;
+    if(!hit->getName().isEmpty()) text += " " + hit->getName();
+
+    QListWidgetItem *item = new QListWidgetItem(text, searchResults);
+    item->setData(Qt::UserRole, QVariant::fromValue((void*)hit));
+  }
+}
+
+void MainWindow::searchIndexReady() {
+  statusBar()->showMessage(tr("Search index ready"), 2000);
+  searchEvent(searchBox->text());
+}
+
+void MainWindow::searchResultClicked(QListWidgetItem *item) {
+  jumpToElement((Element*)item->data(Qt::UserRole).value<void*>());
+}
+
+/* draws the element, expanding all nodes on the way, and centers the view on it */
+void MainWindow::jumpToElement(Element *element) {
+  if(!element) return;
+
+  // keep the currently drawn element if it contains the target
+  Element *root = NULL;
+  for(Element *el = element; el; el = el->parent) {
+    if(el == scene->getLastElement()) {
+      root = el;
+      break;
+    }
+  }
+
+  // otherwise draw the region containing the target
+  if(!root) {
+    for(root = element; root && !root->isRegion(); root = root->parent);
+  }
+  if(!root) return;
+
+  // expand all nodes and summarized regions on the path from root to target
+  for(Element *el = element; el; el = el->parent) {
+    if(el->isRegion()) ((Region*)el)->setShowAll(true);
+    if(el == root) break;
+    if(el->isRegion() && el->parent && el->parent->isComplexNode()) {
+      ((Node*)el->parent)->setExpanded(true);
+    }
+  }
+
+  scene->drawElement(root);
+
+  QModelIndex index = rvsdgModel->indexOf(root);
+  treeView->setCurrentIndex(index);
+  treeView->scrollTo(index);
+
+  if((element != root) && element->getBaseItem()) {
+    graphicsView->centerOn(element->getBaseItem());
+  } else if((element != root) && element->isRegion() && element->parent && element->parent->getBaseItem()) {
+    // drawn regions have no item of their own, their rectangle is placed in the parent node
+    QRectF rect(element->getX(), element->getY(), element->getWidth(), element->getHeight());
+    graphicsView->centerOn(element->parent->getBaseItem()->mapRectToScene(rect).center());
+  } else {
+    graphicsView->centerOn(0, 0);
+  }
 }
 
 void MainWindow::init() {
   rvsdgModel = NULL;
+  baseModel = NULL;
+  timeline = NULL;
+  liveServer = NULL;
+  profile = NULL;
+  searchIndex = NULL;
 
   // central widget
   treeView = new QTreeView();
 
   connect(treeView, SIGNAL(clicked(QModelIndex)), this, SLOT(regionClicked(QModelIndex)));
 
+  searchBox = new QLineEdit();
+  searchBox->setPlaceholderText(tr("Search names and ids"));
+  searchBox->setMaximumWidth(250);
+  connect(searchBox, SIGNAL(textChanged(QString)), this, SLOT(searchEvent(QString)));
+
+  searchResults = new QListWidget();
+  connect(searchResults, SIGNAL(itemClicked(QListWidgetItem*)), this, SLOT(searchResultClicked(QListWidgetItem*)));
+
+  searchWatcher = new QFutureWatcher<void>(this);
+  connect(searchWatcher, SIGNAL(finished()), this, SLOT(searchIndexReady()));
+
+  // live reload
+  reloadPending = false;
+  reloadBusy = false;
+
+  fileWatcher = new QFileSystemWatcher(this);
+  connect(fileWatcher, SIGNAL(fileChanged(QString)), this, SLOT(fileChangedEvent()));
+
+  reloadTimer = new QTimer(this);
+  reloadTimer->setSingleShot(true);
+  connect(reloadTimer, SIGNAL(timeout()), this, SLOT(reloadEvent()));
+
+  reloadWatcher = new QFutureWatcher<Model*>(this);
+  connect(reloadWatcher, SIGNAL(finished()), this, SLOT(reloadFinished()));
+
   colorBox = new QComboBox();
   for(unsigned i = 0; i < sizeof(edgeColors)/sizeof(edgeColors[0]); i++) {
     colorBox->addItem(colorNames[i]);
   }
 
-  scene = new DiagramScene(colorBox, this);
+  traceBox = new QComboBox();
+  for(unsigned i = 0; i < sizeof(traceNames)/sizeof(traceNames[0]); i++) {
+    traceBox->addItem(traceNames[i]);
+  }
+
+  scene = new DiagramScene(colorBox, traceBox, this);
   scene->setSceneRect(QRectF(0, 0, 1024, 512));
 
   graphicsView = new DiagramView(scene);
+
+  connect(scene, SIGNAL(elementSelected(Element*)), this, SLOT(showMetrics(Element*)));
+  connect(scene, SIGNAL(statusMessage(QString)), statusBar(), SLOT(showMessage(QString)));
+  connect(graphicsView, SIGNAL(bandSelected(QRectF,bool)), scene, SLOT(markRect(QRectF,bool)));
   
+  leftSplitter = new QSplitter(Qt::Vertical);
+  leftSplitter->addWidget(treeView);
+  leftSplitter->addWidget(searchResults);
+
   splitter = new QSplitter;
-  splitter->addWidget(treeView);
+  splitter->addWidget(leftSplitter);
   splitter->addWidget(graphicsView);
 
   setCentralWidget(splitter);
 
-  showMaximized();
-
   // actions
   openAct = new QAction(QIcon(":/images/open.png"), tr("&Open..."), this);
   openAct->setShortcuts(QKeySequence::Open);
@@ -84,6 +241,77 @@ void MainWindow::init() {
   clearColorsAct->setStatusTip(tr("Clear edge colors"));
   connect(clearColorsAct, SIGNAL(triggered()), this, SLOT(clearColorsEvent()));
 
+  clearLayerAct = new QAction(tr("Clear &current layer"), this);
+  clearLayerAct->setStatusTip(tr("Clear the edges highlighted in the selected color"));
+  connect(clearLayerAct, SIGNAL(triggered()), this, SLOT(clearLayerEvent()));
+
+  overlapOnlyAct = new QAction(tr("Show &overlap only"), this);
+  overlapOnlyAct->setStatusTip(tr("Only highlight edges present in all visible layers"));
+  overlapOnlyAct->setCheckable(true);
+  connect(overlapOnlyAct, SIGNAL(triggered(bool)), this, SLOT(overlapOnlyEvent(bool)));
+
+  layerVisibleGroup = new QActionGroup(this);
+  layerVisibleGroup->setExclusive(false);
+  for(unsigned i = 0; i < sizeof(edgeColors)/sizeof(edgeColors[0]); i++) {
+    QPixmap icon(16, 16);
+    icon.fill(edgeColors[i]);
+    QAction *action = new QAction(QIcon(icon), colorNames[i], layerVisibleGroup);
+    action->setStatusTip(tr("Show the edges highlighted in %1").arg(colorNames[i].toLower()));
+    action->setCheckable(true);
+    action->setChecked(true);
+    action->setData(i);
+  }
+  connect(layerVisibleGroup, SIGNAL(triggered(QAction*)), this, SLOT(layerVisibleEvent(QAction*)));
+
+  openTimelineAct = new QAction(tr("Open &timeline..."), this);
+  openTimelineAct->setStatusTip(tr("Open a directory of snapshots, e.g. one per optimization pass"));
+  connect(openTimelineAct, SIGNAL(triggered()), this, SLOT(openTimeline()));
+
+  listenAct = new QAction(tr("&Listen for compiler..."), this);
+  listenAct->setStatusTip(tr("Show graphs streamed by a compiler over a local socket"));
+  connect(listenAct, SIGNAL(triggered()), this, SLOT(listenEvent()));
+
+  compareAct = new QAction(tr("&Compare with..."), this);
+  compareAct->setStatusTip(tr("Highlight differences to a baseline file"));
+  connect(compareAct, SIGNAL(triggered()), this, SLOT(compare()));
+
+  showBaselineAct = new QAction(tr("Show &baseline"), this);
+  showBaselineAct->setStatusTip(tr("Show the baseline file, with removed nodes highlighted"));
+  showBaselineAct->setCheckable(true);
+  showBaselineAct->setEnabled(false);
+  connect(showBaselineAct, SIGNAL(toggled(bool)), this, SLOT(showBaselineEvent(bool)));
+
+  loadProfileAct = new QAction(tr("Load &profile..."), this);
+  loadProfileAct->setStatusTip(tr("Load per element metrics from a CSV or JSON file and show them as a heat map"));
+  connect(loadProfileAct, SIGNAL(triggered()), this, SLOT(loadProfileEvent()));
+
+  memoryReportAct = new QAction(tr("&Memory report..."), this);
+  memoryReportAct->setStatusTip(tr("Show memory used by the model and the scene"));
+  connect(memoryReportAct, SIGNAL(triggered()), this, SLOT(memoryReportEvent()));
+
+  frameStatsAct = new QAction(tr("&Frame statistics"), this);
+  frameStatsAct->setStatusTip(tr("Show render time percentiles for pan and zoom"));
+  frameStatsAct->setCheckable(true);
+  connect(frameStatsAct, SIGNAL(toggled(bool)), graphicsView, SLOT(showFrameStats(bool)));
+
+  tiledAct = new QAction(tr("&Tiled rendering"), this);
+  tiledAct->setStatusTip(tr("Render the scene into cached tiles in the background"));
+  tiledAct->setCheckable(true);
+  connect(tiledAct, SIGNAL(toggled(bool)), graphicsView, SLOT(setTiled(bool)));
+  tiledAct->setChecked(true);
+
+  replayAct = new QAction(tr("&Replay pan and zoom"), this);
+  replayAct->setStatusTip(tr("Pan across the scene and zoom in and out, and report the frame times"));
+  connect(replayAct, SIGNAL(triggered()), this, SLOT(replayEvent()));
+
+  summaryBudgetAct = new QAction(tr("&Summary budget..."), this);
+  summaryBudgetAct->setStatusTip(tr("Set the number of vertices drawn before regions are summarized"));
+  connect(summaryBudgetAct, SIGNAL(triggered()), this, SLOT(summaryBudgetEvent()));
+
+  memoryBudgetAct = new QAction(tr("Memory &budget..."), this);
+  memoryBudgetAct->setStatusTip(tr("Set the memory kept for layouts and items of regions not currently drawn"));
+  connect(memoryBudgetAct, SIGNAL(triggered()), this, SLOT(memoryBudgetEvent()));
+
   exitAct = new QAction(tr("E&xit"), this);
   exitAct->setShortcuts(QKeySequence::Quit);
   exitAct->setStatusTip(tr("Exit the application"));
@@ -100,9 +328,40 @@ void MainWindow::init() {
   // menus
   fileMenu = menuBar()->addMenu(tr("&File"));
   fileMenu->addAction(openAct);
+  fileMenu->addAction(openTimelineAct);
+  fileMenu->addAction(listenAct);
+  fileMenu->addAction(compareAct);
+  fileMenu->addAction(loadProfileAct);
+  fileMenu->addAction(showBaselineAct);
   fileMenu->addSeparator();
   fileMenu->addAction(exitAct);
 
+  viewMenu = menuBar()->addMenu(tr("&View"));
+  viewMenu->addAction(summaryBudgetAct);
+  viewMenu->addAction(memoryBudgetAct);
+  viewMenu->addAction(memoryReportAct);
+  viewMenu->addAction(frameStatsAct);
+  viewMenu->addAction(tiledAct);
+  viewMenu->addAction(replayAct);
+
+  highlightMenu = viewMenu->addMenu(tr("&Highlight layers"));
+  highlightMenu->addActions(layerVisibleGroup->actions());
+  highlightMenu->addSeparator();
+  highlightMenu->addAction(overlapOnlyAct);
+  highlightMenu->addAction(clearLayerAct);
+  highlightMenu->addAction(clearColorsAct);
+
+  // metrics panel
+  metricsView = new QTreeWidget();
+  metricsView->setColumnCount(2);
+  metricsView->setHeaderLabels(QStringList() << tr("Metric") << tr("Value"));
+  metricsView->setRootIsDecorated(false);
+
+  metricsDock = new QDockWidget(tr("Metrics"), this);
+  metricsDock->setWidget(metricsView);
+  addDockWidget(Qt::RightDockWidgetArea, metricsDock);
+  viewMenu->addAction(metricsDock->toggleViewAction());
+
   menuBar()->addSeparator();
 
   helpMenu = menuBar()->addMenu(tr("&Help"));
@@ -115,57 +374,560 @@ void MainWindow::init() {
   fileToolBar->addAction(zoomInAct);
   fileToolBar->addAction(zoomOutAct);
   fileToolBar->addWidget(colorBox);
+  fileToolBar->addWidget(traceBox);
   fileToolBar->addAction(clearColorsAct);
+  fileToolBar->addWidget(searchBox);
+
+  metricBox = new QComboBox();
+  metricBox->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+  metricBox->addItem(tr("No profile"));
+  connect(metricBox, SIGNAL(currentIndexChanged(int)), this, SLOT(metricChanged(int)));
+  fileToolBar->addWidget(metricBox);
+
+  timelineSlider = new QSlider(Qt::Horizontal);
+  timelineSlider->setMinimumWidth(300);
+  timelineSlider->setPageStep(1);
+  connect(timelineSlider, SIGNAL(valueChanged(int)), this, SLOT(showSnapshot(int)));
+
+  timelineToolBar = addToolBar(tr("Timeline"));
+  timelineToolBar->addWidget(timelineSlider);
+  timelineToolBar->hide();
 
   // statusbar
   statusBar()->showMessage(tr("Ready"));
 }
 
 MainWindow::~MainWindow() {
-  if(rvsdgModel) delete rvsdgModel;
+  // a finished reload has been handed over by reloadFinished()
+  if(reloadBusy) {
+    reloadWatcher->waitForFinished();
+    delete reloadWatcher->result();
+  }
+  searchWatcher->waitForFinished();
+  delete searchIndex;
+  if(rvsdgModel && !(timeline && timeline->owns(rvsdgModel))) delete rvsdgModel;
+  if(baseModel) delete baseModel;
+  delete timeline;
+  delete profile;
 }
 
 void MainWindow::loadFile(const QString &fileName) {
-  scene->clear();
+  QString error;
+  Model *model = readModel(fileName, error);
+  if(!model) {
+    QMessageBox msgBox;
+    msgBox.setText(error);
+    msgBox.exec();
+    return;
+  }
+
+  openModel(fileName, model);
+}
+
+/* shows a model read from fileName, and reloads it when the file changes */
+void MainWindow::openModel(const QString &fileName, Model *model) {
+  stopListening();
+  scene->clearElement();
 
   QFileInfo fi(fileName);
   setWindowTitle("RVSDG Viewer - " + fi.fileName());
 
-  QDomDocument doc;
-  QFile file(fileName);
-  if(!file.open(QIODevice::ReadOnly)) {
+  setModel(model);
+  closeTimeline();
+
+  // watch the file for changes
+  if(fileWatcher->files().size()) {
+    fileWatcher->removePaths(fileWatcher->files());
+  }
+  this->fileName = fileName;
+  fileWatcher->addPath(fileName);
+}
+
+/* shows the given model (the current one or the diff baseline) in the tree view and scene */
+void MainWindow::showModel(Model *model) {
+  scene->clearElement();
+  metricsView->clear();
+  scene->setHighlights(model ? model->getHighlights() : NULL);
+  scene->setModel(model);
+  if(profile && (model == rvsdgModel)) {
+    scene->setProfile(profile, metricBox->currentIndex() - 1);
+  } else {
+    scene->setProfile(NULL, -1);
+  }
+  treeView->setModel(model);
+  treeView->setColumnWidth(0,250);
+  updateHighlightMenu();
+}
+
+/* replaces the current model, models in the timeline are not deleted */
+void MainWindow::setModel(Model *model) {
+  showBaselineAct->setChecked(false);
+  showModel(NULL);
+  searchResults->clear();
+  searchWatcher->waitForFinished();
+  delete searchIndex;
+  searchIndex = NULL;
+  if(rvsdgModel && !(timeline && timeline->owns(rvsdgModel))) delete rvsdgModel;
+
+  rvsdgModel = model;
+  if(liveServer) liveServer->setModel(model);
+
+  loadProfile();
+  updateDiff();
+  showModel(rvsdgModel);
+
+  buildSearchIndex();
+}
+
+/* builds the search index of the current model in the background */
+void MainWindow::buildSearchIndex() {
+  searchIndex = new SearchIndex(rvsdgModel->getVertices());
+  searchWatcher->setFuture(QtConcurrent::run(searchIndex, &SearchIndex::build));
+}
+
+void MainWindow::updateDiff() {
+  if(!baseModel || !rvsdgModel) return;
+
+  DiffStats stats;
+  diffModels(baseModel, rvsdgModel, stats);
+
+  statusBar()->showMessage(tr("%1 added, %2 removed, %3 changed").arg(stats.added).arg(stats.removed).arg(stats.changed));
+}
+
+void MainWindow::compare() {
+  if(!rvsdgModel) return;
+
+  QString baseName = QFileDialog::getOpenFileName(this, tr("Open Baseline"), QString(), tr(FILE_FILTER));
+  if(baseName.isNull()) return;
+
+  QString error;
+  Model *model = readModel(baseName, error);
+  if(!model) {
     QMessageBox msgBox;
-    msgBox.setText("File not found");
+    msgBox.setText(error);
     msgBox.exec();
     return;
   }
-  if(!doc.setContent(&file)) {
+
+  showBaselineAct->setChecked(false);
+  if(baseModel) delete baseModel;
+  baseModel = model;
+  showBaselineAct->setEnabled(true);
+
+  updateDiff();
+  scene->redraw();
+  treeView->viewport()->update();
+}
+
+void MainWindow::showBaselineEvent(bool checked) {
+  searchResults->clear();
+  searchBox->setEnabled(!checked);
+  showModel(checked ? baseModel : rvsdgModel);
+}
+
+void MainWindow::fileChangedEvent() {
+  // the file may be written in several steps, wait for it to settle
+  reloadTimer->start(RELOAD_DELAY);
+}
+
+void MainWindow::reloadEvent() {
+  if(fileName.isEmpty()) return;
+
+  // the file may have been replaced, which removes it from the watcher
+  if(!fileWatcher->files().contains(fileName)) {
+    fileWatcher->addPath(fileName);
+  }
+
+  // the worker may be done before reloadFinished() has run, so isRunning() is not enough
+  if(reloadBusy) {
+    reloadPending = true;
+    return;
+  }
+  reloadPending = false;
+  reloadBusy = true;
+
+  QString name = fileName;
+  reloadFileName = name;
+  reloadWatcher->setFuture(QtConcurrent::run([name]() {
+    QString error;
+    Model *model = readModel(name, error);
+    if(model) model->moveToThread(qApp->thread());
+    return model;
+  }));
+}
+
+void MainWindow::reloadFinished() {
+  reloadBusy = false;
+  Model *model = reloadWatcher->result();
+
+  if(reloadPending) {
+    delete model;
+    reloadEvent();
+    return;
+  }
+  if(reloadFileName != fileName) {
+    // another file was opened while reloading
+    delete model;
+    return;
+  }
+  if(!model) {
+    statusBar()->showMessage(tr("Reload failed"), 2000);
+    return;
+  }
+
+  replaceModel(model);
+
+  statusBar()->showMessage(tr("Reloaded"), 2000);
+}
+
+/* replaces the current model with a new version of it, keeping expanded nodes,
+   edge colors, layering, the drawn element and the view position */
+void MainWindow::replaceModel(Model *model) {
+  QString lastId;
+  if(scene->getLastElement()) lastId = scene->getLastElement()->id;
+  int hValue = graphicsView->horizontalScrollBar()->value();
+  int vValue = graphicsView->verticalScrollBar()->value();
+
+  if(rvsdgModel) model->transferState(rvsdgModel);
+
+  setModel(model);
+
+  Element *element = lastId.isEmpty() ? NULL : rvsdgModel->getElement(lastId);
+  if(element) {
+    scene->drawElement(element);
+    QModelIndex index = rvsdgModel->indexOf(element);
+    treeView->setCurrentIndex(index);
+    treeView->scrollTo(index);
+    graphicsView->horizontalScrollBar()->setValue(hValue);
+    graphicsView->verticalScrollBar()->setValue(vValue);
+  }
+}
+
+void MainWindow::openTimeline() {
+  QString dirName = QFileDialog::getExistingDirectory(this, tr("Open Timeline"));
+  if(dirName.isNull()) return;
+
+  QDir dir(dirName);
+  QStringList names = dir.entryList(QStringList(FILE_PATTERNS), QDir::Files, QDir::Name);
+  if(names.isEmpty()) {
     QMessageBox msgBox;
-    msgBox.setText("Invalid XML file");
+    msgBox.setText("No RVSDG files found");
     msgBox.exec();
-    file.close();
     return;
   }
-  file.close();
 
-  if(rvsdgModel) delete rvsdgModel;
-  try {
-    rvsdgModel = new Model(doc);
-  } catch (std::exception &e) {
+  stopListening();
+  Timeline *newTimeline = new Timeline;
+
+  QProgressDialog progress(tr("Loading snapshots..."), tr("Cancel"), 0, names.size(), this);
+  progress.setWindowModality(Qt::WindowModal);
+
+  for(int i = 0; i < names.size(); i++) {
+    progress.setValue(i);
+    if(progress.wasCanceled()) break;
+
+    QString error;
+    Model *model = readModel(dir.filePath(names[i]), error);
+    if(model) {
+      newTimeline->append(names[i], model);
+    } else {
+      statusBar()->showMessage(names[i] + ": " + error, 2000);
+    }
+  }
+  progress.setValue(names.size());
+
+  if(!newTimeline->size()) {
+    delete newTimeline;
+    return;
+  }
+
+  // timelines are not reloaded
+  if(fileWatcher->files().size()) {
+    fileWatcher->removePaths(fileWatcher->files());
+  }
+  fileName.clear();
+
+  newTimeline->activate(0);
+  setModel(newTimeline->getSnapshot(0));
+  delete timeline;
+  timeline = newTimeline;
+
+  timelineName = QFileInfo(dirName).fileName();
+  timelineSlider->blockSignals(true);
+  timelineSlider->setRange(0, timeline->size() - 1);
+  timelineSlider->setValue(0);
+  timelineSlider->blockSignals(false);
+  timelineToolBar->show();
+  showSnapshotTitle(0);
+}
+
+void MainWindow::showSnapshotTitle(int n) {
+  setWindowTitle(QString("RVSDG Viewer - %1 [%2/%3] %4").arg(timelineName).arg(n + 1).arg(timeline->size()).arg(timeline->getFileName(n)));
+}
+
+void MainWindow::showSnapshot(int n) {
+  if(!timeline || (n < 0) || ((unsigned)n >= timeline->size())) return;
+
+  timeline->activate(n);
+  replaceModel(timeline->getSnapshot(n));
+  showSnapshotTitle(n);
+}
+
+void MainWindow::closeTimeline() {
+  delete timeline;
+  timeline = NULL;
+  timelineToolBar->hide();
+}
+
+/* starts receiving graphs on the local socket name, replacing any file being shown */
+bool MainWindow::listen(const QString &name) {
+  stopListening();
+
+  liveServer = new LiveServer(this);
+  if(!liveServer->listen(name)) {
     QMessageBox msgBox;
-    msgBox.setText("Invalid RVSDG file");
+    msgBox.setText(tr("Could not listen on %1: %2").arg(name).arg(liveServer->errorString()));
     msgBox.exec();
-    rvsdgModel = NULL;
-    return;
+    stopListening();
+    return false;
   }
+  connect(liveServer, SIGNAL(modelReady(Model*,unsigned,unsigned)), this, SLOT(liveModelReady(Model*,unsigned,unsigned)));
+  connect(liveServer, SIGNAL(modelUpdated(unsigned,unsigned)), this, SLOT(liveModelUpdated(unsigned,unsigned)));
 
-  treeView->setModel(rvsdgModel);
-  treeView->setColumnWidth(0,250);
+  // live graphs do not come from a file
+  if(fileWatcher->files().size()) {
+    fileWatcher->removePaths(fileWatcher->files());
+  }
+  fileName.clear();
+
+  setWindowTitle("RVSDG Viewer - " + name);
+  statusBar()->showMessage(tr("Listening on %1").arg(liveServer->serverName()));
+
+  return true;
 }
 
-void MainWindow::clearColorsEvent() {
-  if(rvsdgModel) {
-    rvsdgModel->clearColors();
+void MainWindow::stopListening() {
+  delete liveServer;
+  liveServer = NULL;
+}
+
+void MainWindow::listenEvent() {
+  bool ok;
+  QString name = QInputDialog::getText(this, tr("Listen for compiler"), tr("Local socket name:"),
+                                       QLineEdit::Normal, LIVE_SERVER_NAME, &ok);
+  if(ok && !name.isEmpty()) listen(name);
+}
+
+/* a live snapshot has been built, shown like a reload so expanded nodes,
+   colors and the layout of unchanged regions are kept */
+void MainWindow::liveModelReady(Model *model, unsigned frames, unsigned rejected) {
+  replaceModel(model);
+  closeTimeline();
+
+  if(rejected) {
+    statusBar()->showMessage(tr("Live update: %1 frames, %2 ignored").arg(frames).arg(rejected), 2000);
+  } else {
+    statusBar()->showMessage(tr("Live update: %1 frames").arg(frames), 2000);
+  }
+}
+
+/* a batch of live updates has been applied to the current model in place */
+void MainWindow::liveModelUpdated(unsigned frames, unsigned rejected) {
+  // the search index may refer to removed elements, it is built again when searched
+  searchWatcher->waitForFinished();
+  delete searchIndex;
+  searchIndex = NULL;
+  searchResults->clear();
+
+  bool shown = !showBaselineAct->isChecked();
+
+  // profile values are by element number, which removals change
+  if(profile) {
+    if(shown) scene->setProfile(NULL, -1);
+    loadProfile();
+  }
+
+  if(shown) {
+    scene->modelChanged();
+    if(profile) scene->setProfile(profile, metricBox->currentIndex() - 1);
+  }
+
+  if(rejected) {
+    statusBar()->showMessage(tr("Live update: %1 frames, %2 ignored").arg(frames).arg(rejected), 2000);
+  } else {
+    statusBar()->showMessage(tr("Live update: %1 frames").arg(frames), 2000);
+  }
+}
+
+/* memory breakdown of the current model, the baseline and the scene */
+QString MainWindow::memoryReport() {
+  MemoryReport report;
+  if(rvsdgModel) report.addModel(rvsdgModel);
+  if(baseModel) report.addModel(baseModel);
+  report.addScene(scene);
+  return report.toString();
+}
+
+void MainWindow::memoryReportEvent() {
+  QDialog dialog(this);
+  dialog.setWindowTitle(tr("Memory report"));
+
+  QPlainTextEdit *text = new QPlainTextEdit(memoryReport());
+  text->setReadOnly(true);
+  text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+  QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+  connect(buttons, SIGNAL(rejected()), &dialog, SLOT(reject()));
+
+  QVBoxLayout *layout = new QVBoxLayout(&dialog);
+  layout->addWidget(text);
+  layout->addWidget(buttons);
+  dialog.resize(600, 500);
+  dialog.exec();
+}
+
+/* runs the scripted pan and zoom replay on the current scene */
+QString MainWindow::replay() {
+  return graphicsView->replay();
+}
+
+void MainWindow::replayEvent() {
+  QString report = replay();
+  QTextStream(stdout) << report;
+
+  QMessageBox msgBox;
+  msgBox.setText(report);
+  msgBox.exec();
+}
+
+/* draws the top level region, as when clicking it in the tree view,
+   returns false if nothing was drawn */
+bool MainWindow::drawTop() {
+  if(!rvsdgModel) return false;
+
+  // the top element is the document root, which draws nothing itself
+  for(auto child : rvsdgModel->getTop()->children) {
+    if(child->isRegion()) {
+      scene->drawElement(child);
+      // drawn items all hang below the scene's root item
+      return scene->items().size() > 1;
+    }
+  }
+  return false;
+}
+
+void MainWindow::summaryBudgetEvent() {
+  bool ok;
+  int budget = QInputDialog::getInt(this, tr("Summary Budget"), tr("Vertices drawn before regions are summarized:"),
+                                    scene->getSummaryBudget(), 1, INT_MAX, 100, &ok);
+  if(ok) {
+    scene->setSummaryBudget(budget);
     scene->redraw();
   }
 }
+
+void MainWindow::memoryBudgetEvent() {
+  bool ok;
+  int budget = QInputDialog::getInt(this, tr("Memory Budget"), tr("MB kept for layouts and items not currently drawn:"),
+                                    scene->getMemoryBudget() / (1024*1024), 0, 1024*1024, 16, &ok);
+  if(ok) {
+    scene->setMemoryBudget((quint64)budget * 1024*1024);
+    scene->redraw();
+  }
+}
+
+/* joins the profile file with the current model */
+void MainWindow::loadProfile() {
+  int metric = metricBox->currentIndex();
+
+  delete profile;
+  profile = NULL;
+
+  metricBox->blockSignals(true);
+  metricBox->clear();
+  metricBox->addItem(tr("No profile"));
+
+  if(!profileFileName.isEmpty() && rvsdgModel) {
+    QString error;
+    profile = new Profile;
+    if(profile->load(profileFileName, rvsdgModel, error)) {
+      metricBox->addItems(profile->metrics);
+      if(metric < 1) metric = 1;
+      if(metric < metricBox->count()) metricBox->setCurrentIndex(metric);
+      statusBar()->showMessage(tr("Profile: %1 of %2 rows matched").arg(profile->matched).arg(profile->rows), 2000);
+    } else {
+      statusBar()->showMessage(tr("Profile: ") + error, 2000);
+      delete profile;
+      profile = NULL;
+      profileFileName.clear();
+    }
+  }
+
+  metricBox->blockSignals(false);
+}
+
+void MainWindow::loadProfileEvent() {
+  if(!rvsdgModel) return;
+
+  QString name = QFileDialog::getOpenFileName(this, tr("Load Profile"), QString(), tr("Profile files (*.csv *.json)"));
+  if(name.isNull()) return;
+
+  profileFileName = name;
+  loadProfile();
+  showBaselineAct->setChecked(false);
+  scene->setProfile(profile, metricBox->currentIndex() - 1);
+}
+
+void MainWindow::metricChanged(int index) {
+  if(profile && (treeView->model() == rvsdgModel)) {
+    scene->setProfile(profile, index - 1);
+  }
+}
+
+/* highlight layers of the model shown in the scene, NULL if none */
+Highlights *MainWindow::shownHighlights() {
+  Model *model = (Model*)treeView->model();
+  return model ? model->getHighlights() : NULL;
+}
+
+void MainWindow::updateHighlightMenu() {
+  Highlights *highlights = shownHighlights();
+  if(!highlights) return;
+
+  for(auto action : layerVisibleGroup->actions()) {
+    action->setChecked(highlights->getLayer(action->data().toUInt()).visible);
+  }
+  overlapOnlyAct->setChecked(highlights->getOverlapOnly());
+}
+
+void MainWindow::clearColorsEvent() {
+  Model *model = (Model*)treeView->model();
+  if(model) {
+    model->clearColors();
+    scene->recolor();
+  }
+}
+
+void MainWindow::clearLayerEvent() {
+  Highlights *highlights = shownHighlights();
+  if(highlights) {
+    highlights->clear(colorBox->currentIndex());
+    scene->recolor();
+  }
+}
+
+void MainWindow::layerVisibleEvent(QAction *action) {
+  Highlights *highlights = shownHighlights();
+  if(highlights) {
+    highlights->setVisible(action->data().toUInt(), action->isChecked());
+    scene->recolor();
+  }
+}
+
+void MainWindow::overlapOnlyEvent(bool checked) {
+  Highlights *highlights = shownHighlights();
+  if(highlights) {
+    highlights->setOverlapOnly(checked);
+    scene->recolor();
+  }
+}
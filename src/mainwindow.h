@@ -16,6 +16,11 @@
 #include "diagramscene.h"
 #include "element.h"
 #include "model.h"
+#include "search.h"
+
+class Timeline;
+class DiagramView;
+class LiveServer;
 
 class MainWindow : public QMainWindow {
   Q_OBJECT
@@ -23,8 +28,14 @@ class MainWindow : public QMainWindow {
 public:
   MainWindow();
   MainWindow(const QString &fileName);
+  MainWindow(const QString &fileName, Model *model);
   ~MainWindow();
 
+  QString memoryReport();
+  QString replay();
+  bool drawTop();
+  bool listen(const QString &name);
+
 protected:
   void closeEvent(QCloseEvent *event) Q_DECL_OVERRIDE;
 
@@ -32,19 +43,81 @@ private slots:
   void open();
   void about();
   void clearColorsEvent();
+  void clearLayerEvent();
+  void layerVisibleEvent(QAction *action);
+  void overlapOnlyEvent(bool checked);
+  void summaryBudgetEvent();
+  void memoryBudgetEvent();
+  void memoryReportEvent();
+  void replayEvent();
+  void loadProfileEvent();
+  void metricChanged(int index);
+  void showMetrics(Element *element);
   void regionClicked(const QModelIndex &index);
+  void searchEvent(const QString &pattern);
+  void searchIndexReady();
+  void searchResultClicked(QListWidgetItem *item);
+  void fileChangedEvent();
+  void reloadEvent();
+  void reloadFinished();
+  void compare();
+  void showBaselineEvent(bool checked);
+  void openTimeline();
+  void showSnapshot(int n);
+  void listenEvent();
+  void liveModelReady(Model *model, unsigned frames, unsigned rejected);
+  void liveModelUpdated(unsigned frames, unsigned rejected);
 
 private:
   void init();
   void loadFile(const QString &fileName);
+  void openModel(const QString &fileName, Model *model);
+  void setModel(Model *model);
+  void showModel(Model *model);
+  void buildSearchIndex();
+  void updateDiff();
+  void replaceModel(Model *model);
+  void showSnapshotTitle(int n);
+  void closeTimeline();
+  void stopListening();
+  void loadProfile();
+  void jumpToElement(Element *element);
+  Highlights *shownHighlights();
+  void updateHighlightMenu();
 
   QTreeView *treeView;
+  QLineEdit *searchBox;
+  QListWidget *searchResults;
+  SearchIndex *searchIndex;
+  QFutureWatcher<void> *searchWatcher;
+  QString fileName;
+  QFileSystemWatcher *fileWatcher;
+  QTimer *reloadTimer;
+  QFutureWatcher<Model*> *reloadWatcher;
+  QString reloadFileName;
+  bool reloadPending;
+  bool reloadBusy; // from reloadEvent() until reloadFinished() has run
   DiagramScene *scene;
-  QGraphicsView *graphicsView;
+  DiagramView *graphicsView;
   QComboBox *colorBox;
+  QComboBox *traceBox;
   Model *rvsdgModel;
+  Model *baseModel; // baseline in diff mode, NULL otherwise
+  Timeline *timeline; // NULL unless in timeline mode
+  LiveServer *liveServer; // NULL unless receiving a live stream
+  Profile *profile;
+  QString profileFileName;
+  QComboBox *metricBox;
+  QDockWidget *metricsDock;
+  QTreeWidget *metricsView;
+  QString timelineName;
+  QSlider *timelineSlider;
+  QToolBar *timelineToolBar;
   QSplitter *splitter;
+  QSplitter *leftSplitter;
   QMenu *fileMenu;
+  QMenu *viewMenu;
+  QMenu *highlightMenu;
   QMenu *helpMenu;
   QToolBar *fileToolBar;
   QAction *openAct;
@@ -54,6 +127,20 @@ private:
   QAction *zoomInAct;
   QAction *zoomOutAct;
   QAction *clearColorsAct;
+  QAction *clearLayerAct;
+  QAction *overlapOnlyAct;
+  QActionGroup *layerVisibleGroup;
+  QAction *summaryBudgetAct;
+  QAction *memoryBudgetAct;
+  QAction *memoryReportAct;
+  QAction *frameStatsAct;
+  QAction *tiledAct;
+  QAction *replayAct;
+  QAction *loadProfileAct;
+  QAction *openTimelineAct;
+  QAction *listenAct;
+  QAction *compareAct;
+  QAction *showBaselineAct;
 };
 
 #endif
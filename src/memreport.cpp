@@ -0,0 +1,177 @@
+#include <QGraphicsItem>
+#include <QFile>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#include "memreport.h"
+#include "node.h"
+#include "region.h"
+#include "input.h"
+#include "output.h"
+#include "argument.h"
+#include "result.h"
+#include "stats.h"
+
+QMutex MemoryReport::peakMutex;
+QMap<QString,quint64> MemoryReport::peaks;
+
+template<typename T> static quint64 vectorBytes(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
+}
+
+static quint64 stringBytes(const QString &s) {
+  if(s.isNull()) return 0;
+  return sizeof(QArrayData) + (s.capacity() + 1) * sizeof(QChar);
+}
+
+void MemoryReport::add(const QString &category, quint64 count, quint64 bytes) {
+  Entry &entry = entries[category];
+  entry.count += count;
+  entry.bytes += bytes;
+}
+
+void MemoryReport::addElement(Element *element) {
+  quint64 vectors = vectorBytes(element->children) + vectorBytes(element->treeChildren)
+    + vectorBytes(element->edges) + vectorBytes(element->inEdges);
+
+  if(Node *node = dynamic_cast<Node*>(element)) {
+    add("Element: Node", 1, sizeof(Node));
+    add("Strings", 1, stringBytes(node->getName()));
+    vectors += vectorBytes(node->inputs) + vectorBytes(node->outputs);
+  } else if(Region *region = dynamic_cast<Region*>(element)) {
+    add("Element: Region", 1, sizeof(Region));
+    vectors += vectorBytes(region->arguments) + vectorBytes(region->results);
+    quint64 layers = vectorBytes(region->layers);
+    for(auto layer : region->layers) {
+      layers += sizeof(*layer) + vectorBytes(*layer);
+    }
+    add("Region layers", region->layers.size(), layers);
+    add("Region layout", region->slotVertices.size(),
+        vectorBytes(region->slotVertices) + vectorBytes(region->slotRows) + vectorBytes(region->slotColumns)
+        + vectorBytes(region->slotX) + vectorBytes(region->slotY)
+        + vectorBytes(region->slotWidths) + vectorBytes(region->slotHeights));
+  } else if(dynamic_cast<Input*>(element)) {
+    add("Element: Input", 1, sizeof(Input));
+  } else if(dynamic_cast<Output*>(element)) {
+    add("Element: Output", 1, sizeof(Output));
+  } else if(dynamic_cast<Argument*>(element)) {
+    add("Element: Argument", 1, sizeof(Argument));
+  } else if(dynamic_cast<Result*>(element)) {
+    add("Element: Result", 1, sizeof(Result));
+  } else {
+    add("Element: other", 1, sizeof(Element));
+  }
+
+  add("Element vectors", 0, vectors);
+  add("Edges", element->edges.size(), element->edges.size() * sizeof(Edge));
+  add("Line segments", element->lineSegments.size(), vectorBytes(element->lineSegments));
+  add("Strings", 1, stringBytes(element->id));
+  if(element->stats) add("Subtree stats", 1, sizeof(SubtreeStats));
+}
+
+void MemoryReport::addModel(Model *model) {
+  const std::vector<Element*> &vertices = model->getVertices();
+
+  addElement(model->getTop());
+  for(auto element : vertices) {
+    addElement(element);
+  }
+
+  // the id hash stores one node per element, plus the bucket array
+  add("Index: id hash", vertices.size(),
+      vertices.size() * (sizeof(void*) + sizeof(uint) + sizeof(QString) + sizeof(Element*) + sizeof(void*)));
+  add("Index: vertices", vertices.size(), vectorBytes(vertices));
+  if(model->getDataflow()) add("Index: dataflow", 1, model->getDataflow()->getMemoryUsage());
+}
+
+void MemoryReport::addScene(QGraphicsScene *scene) {
+  for(auto item : scene->items()) {
+    switch(item->type()) {
+      case QGraphicsLineItem::Type:
+        add("Scene: line items", 1, sizeof(QGraphicsLineItem));
+        break;
+      case QGraphicsPolygonItem::Type: {
+        QGraphicsPolygonItem *poly = qgraphicsitem_cast<QGraphicsPolygonItem*>(item);
+        add("Scene: polygon items", 1, sizeof(QGraphicsPolygonItem) + poly->polygon().capacity() * sizeof(QPointF));
+        break;
+      }
+      case QGraphicsTextItem::Type: {
+        QGraphicsTextItem *text = qgraphicsitem_cast<QGraphicsTextItem*>(item);
+        add("Scene: text items", 1, sizeof(QGraphicsTextItem) + stringBytes(text->toPlainText()));
+        break;
+      }
+      default:
+        add("Scene: other items", 1, sizeof(QGraphicsItem));
+        break;
+    }
+  }
+}
+
+quint64 MemoryReport::getTotal() const {
+  quint64 total = 0;
+  for(auto &entry : entries) {
+    total += entry.bytes;
+  }
+  return total;
+}
+
+static QString formatBytes(quint64 bytes) {
+  if(bytes >= 1024*1024*1024) return QString("%1 GB").arg(bytes / (1024.0*1024*1024), 0, 'f', 2);
+  if(bytes >= 1024*1024) return QString("%1 MB").arg(bytes / (1024.0*1024), 0, 'f', 2);
+  if(bytes >= 1024) return QString("%1 kB").arg(bytes / 1024.0, 0, 'f', 2);
+  return QString("%1 B").arg(bytes);
+}
+
+QString MemoryReport::toString() const {
+  QString report;
+
+  for(auto it = entries.constBegin(); it != entries.constEnd(); it++) {
+    report += QString("%1 %2 %3\n").arg(it.key(), -24).arg(it.value().count, 10).arg(formatBytes(it.value().bytes), 12);
+  }
+  report += QString("%1 %2 %3\n").arg("Total", -24).arg("", 10).arg(formatBytes(getTotal()), 12);
+
+  report += "\n";
+  report += QString("%1 %2\n").arg("Resident", -24).arg(formatBytes(getResident()), 23);
+  report += QString("%1 %2\n").arg("Peak resident", -24).arg(formatBytes(getPeakResident()), 23);
+
+  QMutexLocker locker(&peakMutex);
+  for(auto it = peaks.constBegin(); it != peaks.constEnd(); it++) {
+    report += QString("%1 %2\n").arg("Peak during " + it.key(), -24).arg(formatBytes(it.value()), 23);
+  }
+
+  return report;
+}
+
+quint64 MemoryReport::getResident() {
+#ifdef Q_OS_LINUX
+  QFile file("/proc/self/statm");
+  if(file.open(QIODevice::ReadOnly)) {
+    QList<QByteArray> fields = file.readAll().split(' ');
+    if(fields.size() > 1) return fields[1].toULongLong() * sysconf(_SC_PAGESIZE);
+  }
+#endif
+  return 0;
+}
+
+quint64 MemoryReport::getPeakResident() {
+#ifdef Q_OS_UNIX
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss;
+#else
+    return (quint64)usage.ru_maxrss * 1024;
+#endif
+  }
+#endif
+  return 0;
+}
+
+void MemoryReport::samplePeak(const QString &phase) {
+  quint64 resident = getResident();
+  QMutexLocker locker(&peakMutex);
+  if(resident > peaks.value(phase, 0)) peaks[phase] = resident;
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+ *
+ * Memory accounting for the model and the scene
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef MEMREPORT_H
+#define MEMREPORT_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QGraphicsScene>
+
+#include "model.h"
+
+class MemoryReport {
+  class Entry {
+  public:
+    quint64 count;
+    quint64 bytes;
+
+    Entry() {
+      count = bytes = 0;
+    }
+  };
+
+  QMap<QString,Entry> entries;
+
+  static QMutex peakMutex;
+  static QMap<QString,quint64> peaks; // peak resident size, by phase
+
+  void add(const QString &category, quint64 count, quint64 bytes);
+  void addElement(Element *element);
+
+public:
+  /* adds the element graph and indices of model, sizes are estimates of
+     the heap usage, excluding allocator overhead */
+  void addModel(Model *model);
+
+  /* adds all graphics items of scene, by item type */
+  void addScene(QGraphicsScene *scene);
+
+  quint64 getTotal() const;
+  QString toString() const;
+
+  /* current and peak resident size of the process, 0 if unknown */
+  static quint64 getResident();
+  static quint64 getPeakResident();
+
+  /* records the current resident size as a candidate peak for the given phase
+     (e.g. "load" or "draw"), may be called from any thread */
+  static void samplePeak(const QString &phase);
+};
+
+#endif
@@ -1,5 +1,14 @@
+#include <QtConcurrent>
+#include <algorithm>
+#include <QSet>
+
 #include "model.h"
+#include "bitset.h"
 #include "edge.h"
+#include "node.h"
+#include "region.h"
+#include "decompress.h"
+#include "memreport.h"
 
 QModelIndex Model::index(int treeviewRow, int column, const QModelIndex &parent) const {
   if (!hasIndex(treeviewRow, column, parent))
@@ -12,21 +21,10 @@ QModelIndex Model::index(int treeviewRow, int column, const QModelIndex &parent)
   else
     parentEl = static_cast<Element*>(parent.internalPointer());
 
-  Element *childEl = NULL;
-
-  int n = 0;
-  for(auto it : parentEl->children) {
-    if(!it->isSimpleNode()) {
-      if(treeviewRow == n) {
-        childEl = it;
-        break;
-      }
-      n++;
-    }
-  }
+  if ((unsigned)treeviewRow >= parentEl->treeChildren.size())
+    return QModelIndex();
 
-  if (childEl) return createIndex(treeviewRow, column, childEl);
-  else return QModelIndex();
+  return createIndex(treeviewRow, column, parentEl->treeChildren[treeviewRow]);
 }
 
 QModelIndex Model::parent(const QModelIndex &index) const {
@@ -43,15 +41,18 @@ QModelIndex Model::parent(const QModelIndex &index) const {
   return createIndex(parentEl->treeviewRow, 0, parentEl);
 }
 
+QModelIndex Model::indexOf(Element *element) const {
+  if((element == NULL) || (element == top))
+    return QModelIndex();
+
+  return createIndex(element->treeviewRow, 0, element);
+}
+
 int Model::rowCount(const QModelIndex &parent) const {
   if (parent.isValid()) {
-    unsigned n = 0;
-    for(auto child : static_cast<Element*>(parent.internalPointer())->children) {
-      if(!child->isSimpleNode()) n++;
-    }
-    return n;
+    return static_cast<Element*>(parent.internalPointer())->treeChildren.size();
   } else {
-    return top->children.size();
+    return top->treeChildren.size();
   }
 }
 
@@ -64,10 +65,16 @@ QVariant Model::data(const QModelIndex &index, int role) const {
   if (!index.isValid())
     return QVariant();
 
-  if (role != Qt::DisplayRole)
+  Element *el = static_cast<Element*>(index.internalPointer());
+
+  if (role == Qt::BackgroundRole) {
+    QColor color;
+    if (el->getDiffColor(color)) return QBrush(color.lighter(170));
     return QVariant();
+  }
 
-  Element *el = static_cast<Element*>(index.internalPointer());
+  if (role != Qt::DisplayRole)
+    return QVariant();
 
   switch(index.column()) {
     case 0:
@@ -108,18 +115,587 @@ Model::Model(const QDomDocument &doc, QObject *parent) : QAbstractItemModel(pare
     if(!e.isNull()) {
       QString source = e.attribute(ATTR_SOURCE);
       QString target = e.attribute(ATTR_TARGET);
-      Element *sourceEl = elements.at(source);
-      Element *targetEl = elements.at(target);
+      Element *sourceEl = elements.value(source, NULL);
+      Element *targetEl = elements.value(target, NULL);
 
       if((sourceEl == NULL) || (targetEl == NULL)) {
         delete top;
         throw std::exception();
       }
-      sourceEl->appendEdge(new Edge(targetEl));
+      Edge *edge = new Edge(sourceEl, targetEl);
+      sourceEl->appendEdge(edge);
+      targetEl->appendInEdge(edge);
+    }
+  }
+
+  dataflow = NULL;
+  buildIndex();
+}
+
+Model::~Model() {
+  for(auto element : removed) delete element;
+  for(auto edge : removedEdges) delete edge;
+  for(auto element : detached) delete element;
+  for(auto edge : detachedEdges) delete edge;
+  delete dataflow;
+  delete top;
+}
+
+/* builds the tree view children, the dense element and edge numbering and the dataflow index */
+void Model::buildIndex() {
+  top->buildTreeChildren();
+
+  vertices.clear();
+  vertices.reserve(elements.size());
+  for(auto el : elements) {
+    el->number = vertices.size();
+    vertices.push_back(el);
+  }
+
+  regions.clear();
+  for(auto el : vertices) {
+    if(el->isRegion()) regions.push_back((Region*)el);
+  }
+
+  edges.clear();
+  for(auto el : vertices) {
+    for(auto edge : el->edges) {
+      edge->number = edges.size();
+      edges.push_back(edge);
+    }
+  }
+
+  delete dataflow;
+  dataflow = new Dataflow(vertices);
+
+  computeStats();
+}
+
+static void collectElements(Element *element, QHash<QString,Element*> &elements) {
+  std::vector<Element*> ports;
+  element->getPorts(ports);
+  for(auto port : ports) {
+    elements[port->id] = port;
+  }
+  for(auto child : element->children) {
+    elements[child->id] = child;
+    collectElements(child, elements);
+  }
+}
+
+/* rebuilds all indices after subtrees have been replaced */
+void Model::rebuildIndex() {
+  elements.clear();
+  collectElements(top, elements);
+  buildIndex();
+}
+
+/* restores the element numbering of this model, for elements shared with other models */
+void Model::renumber() {
+  for(unsigned i = 0; i < vertices.size(); i++) {
+    vertices[i]->number = i;
+  }
+  for(unsigned i = 0; i < edges.size(); i++) {
+    edges[i]->number = i;
+  }
+}
+
+quint64 Model::getLayoutMemory() {
+  quint64 bytes = 0;
+  for(auto region : regions) {
+    bytes += region->getLayoutMemory();
+  }
+  return bytes;
+}
+
+void Model::evictLayouts(quint64 budget) {
+  std::vector<std::pair<unsigned,unsigned> > drawn; // last drawn, index into regions
+  std::vector<quint64> sizes(regions.size(), 0);
+  quint64 bytes = 0;
+  for(unsigned i = 0; i < regions.size(); i++) {
+    sizes[i] = regions[i]->getLayoutMemory();
+    if(!sizes[i]) continue;
+    drawn.push_back(std::make_pair(regions[i]->getLastDrawn(), i));
+    bytes += sizes[i];
+  }
+  if(bytes <= budget) return;
+
+  std::sort(drawn.begin(), drawn.end());
+
+  for(auto &entry : drawn) {
+    if((bytes <= budget) || (entry.first == Region::drawStamp)) break;
+    bytes -= sizes[entry.second];
+    regions[entry.second]->evictLayout();
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// live updates
+//
+// elements and edges keep dense numbers: new ones are appended, and a removed
+// one is replaced by the last one. Only the indices an update touches are
+// maintained, the dataflow index is dropped and rebuilt when next needed
+
+template<typename T> static void eraseFrom(std::vector<T> &v, T value) {
+  auto it = std::find(v.begin(), v.end(), value);
+  if(it != v.end()) v.erase(it);
+}
+
+static bool isNode(Element *element) {
+  return element->isSimpleNode() || element->isComplexNode();
+}
+
+/* element, its ports and all elements below it */
+static void collectSubtree(Element *element, std::vector<Element*> &subtree) {
+  subtree.push_back(element);
+  element->getPorts(subtree);
+  for(auto child : element->children) {
+    collectSubtree(child, subtree);
+  }
+}
+
+/* true if all ids in the XML subtree are new and unique */
+static bool newIds(const QDomElement &element, const QHash<QString,Element*> &elements, QSet<QString> &ids) {
+  if(element.tagName() == TAG_EDGE) return true;
+
+  QString id = element.attribute(ATTR_ID);
+  if(id.isEmpty() || elements.contains(id) || ids.contains(id)) return false;
+  ids.insert(id);
+
+  for(QDomElement child = element.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+    if(!newIds(child, elements, ids)) return false;
+  }
+  return true;
+}
+
+static unsigned depthOf(Element *element) {
+  unsigned depth = 0;
+  for(; element->parent; element = element->parent) depth++;
+  return depth;
+}
+
+static bool deeper(Element *a, Element *b) {
+  return depthOf(a) > depthOf(b);
+}
+
+static void computeSubtreeStats(Element *element) {
+  for(auto child : element->children) {
+    computeSubtreeStats(child);
+  }
+  element->computeStats();
+}
+
+void Model::appendVertex(Element *element) {
+  element->number = vertices.size();
+  vertices.push_back(element);
+  elements[element->id] = element;
+  if(element->isRegion()) regions.push_back((Region*)element);
+}
+
+void Model::dropVertex(Element *element) {
+  Element *last = vertices.back();
+  vertices[element->number] = last;
+  last->number = element->number;
+  vertices.pop_back();
+
+  elements.remove(element->id);
+  if(element->isRegion()) {
+    auto it = std::find(regions.begin(), regions.end(), (Region*)element);
+    *it = regions.back();
+    regions.pop_back();
+  }
+}
+
+void Model::appendEdgeNumber(Edge *edge) {
+  edge->number = edges.size();
+  edges.push_back(edge);
+}
+
+void Model::dropEdge(Edge *edge) {
+  Edge *last = edges.back();
+  edges[edge->number] = last;
+  highlights.moveEdge(last->number, edge->number);
+  last->number = edge->number;
+  edges.pop_back();
+}
+
+/* the region laying out edges to and from port */
+void Model::touchPort(Element *port) {
+  Element *region = port->parent;
+  if(region && !region->isRegion()) region = region->parent;
+  if(region) touched.push_back(region);
+}
+
+bool Model::isAttached(Element *element) {
+  while(element->parent) element = element->parent;
+  return element == top;
+}
+
+bool Model::addElement(const QString &parentId, const QDomElement &element) {
+  Element *parent = parentId.isEmpty() ? top : getElement(parentId);
+  if(!parent) return false;
+
+  if(element.tagName() == TAG_EDGE) {
+    return addEdge(element.attribute(ATTR_SOURCE), element.attribute(ATTR_TARGET));
+  }
+
+  // only where the element could appear in a file
+  QString tagName = element.tagName();
+  bool fits = false;
+  if(tagName == TAG_NODE) fits = parent->isRegion() || (parent == top);
+  else if(tagName == TAG_REGION) fits = isNode(parent) || (parent == top);
+  else if((tagName == TAG_INPUT) || (tagName == TAG_OUTPUT)) fits = isNode(parent);
+  else if((tagName == TAG_ARGUMENT) || (tagName == TAG_RESULT)) fits = parent->isRegion();
+  if(!fits) return false;
+
+  QSet<QString> ids;
+  if(!newIds(element, elements, ids)) return false;
+
+  parent->constructFromXml(element, 0, elements);
+  Element *child = elements.value(element.attribute(ATTR_ID));
+
+  std::vector<Element*> subtree;
+  collectSubtree(child, subtree);
+  for(auto el : subtree) {
+    appendVertex(el);
+  }
+
+  bool ok = true;
+  QDomNodeList edgeList = element.elementsByTagName(TAG_EDGE);
+  for(int i = 0; i < edgeList.length(); i++) {
+    QDomElement e = edgeList.at(i).toElement();
+    if(!addEdge(e.attribute(ATTR_SOURCE), e.attribute(ATTR_TARGET))) ok = false;
+  }
+
+  added.push_back(child);
+  touched.push_back(parent);
+  if(!isNode(child) && !child->isRegion()) touchPort(child);
+
+  return ok;
+}
+
+bool Model::removeElement(const QString &id) {
+  Element *element = getElement(id);
+  if(!element) return false;
+
+  std::vector<Element*> subtree;
+  collectSubtree(element, subtree);
+
+  Bitset inside(vertices.size());
+  for(auto el : subtree) {
+    inside.set(el->number);
+  }
+
+  // edges within the subtree go with it, the others are unlinked from the rest of the graph
+  for(auto el : subtree) {
+    for(auto edge : el->edges) {
+      dropEdge(edge);
+      if(!inside.test(edge->target->number)) {
+        eraseFrom(edge->target->inEdges, edge);
+        touchPort(edge->target);
+      }
     }
+    for(auto edge : el->inEdges) {
+      if(!inside.test(edge->source->number)) {
+        dropEdge(edge);
+        eraseFrom(edge->source->edges, edge);
+        touchPort(edge->source);
+        removedEdges.push_back(edge);
+      }
+    }
+  }
+
+  Element *parent = element->parent;
+  if(!isNode(element) && !element->isRegion()) touchPort(element);
+  eraseFrom(parent->children, element);
+  if(isNode(parent)) {
+    eraseFrom(((Node*)parent)->inputs, element);
+    eraseFrom(((Node*)parent)->outputs, element);
+  } else if(parent->isRegion()) {
+    eraseFrom(((Region*)parent)->arguments, element);
+    eraseFrom(((Region*)parent)->results, element);
+  }
+  element->parent = NULL;
+  touched.push_back(parent);
+
+  for(auto el : subtree) {
+    dropVertex(el);
   }
+  removed.push_back(element);
+
+  return true;
+}
+
+bool Model::modifyElement(const QString &id, const QString &key, const QString &value) {
+  Element *element = getElement(id);
+  if(!element || !isNode(element)) return false;
+
+  Node *node = (Node*)element;
+  if(key == ATTR_NAME) node->setName(value);
+  else if(key == ATTR_TYPE) node->setType(parseNodeType(value));
+  else return false;
+
+  // the type and name are shown in the tree view, and the type is counted in the stats
+  touched.push_back(node);
+  if(node->isComplexNode()) {
+    QModelIndex index = indexOf(node);
+    emit dataChanged(index, index.sibling(index.row(), 1));
+  }
+  return true;
+}
+
+bool Model::addEdge(const QString &source, const QString &target) {
+  Element *sourceEl = getElement(source);
+  Element *targetEl = getElement(target);
+  if(!sourceEl || !targetEl) return false;
+
+  Edge *edge = new Edge(sourceEl, targetEl);
+  sourceEl->appendEdge(edge);
+  targetEl->appendInEdge(edge);
+  appendEdgeNumber(edge);
+
+  touchPort(sourceEl);
+  touchPort(targetEl);
+  return true;
+}
+
+bool Model::removeEdge(const QString &source, const QString &target) {
+  Element *sourceEl = getElement(source);
+  if(!sourceEl) return false;
+
+  for(auto edge : sourceEl->edges) {
+    if(edge->target->id == target) {
+      dropEdge(edge);
+      eraseFrom(sourceEl->edges, edge);
+      eraseFrom(edge->target->inEdges, edge);
+      touchPort(sourceEl);
+      touchPort(edge->target);
+      removedEdges.push_back(edge);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* brings the tree view rows of parent up to date with its children, rows that are
+   still there are kept so the view keeps their expanded state and selection */
+void Model::refreshTreeRows(Element *parent) {
+  std::vector<Element*> rows;
+  for(auto child : parent->children) {
+    if(!child->isSimpleNode()) rows.push_back(child);
+  }
+  if(rows == parent->treeChildren) return;
+
+  QModelIndex index = indexOf(parent);
+  std::vector<Element*> &current = parent->treeChildren;
+
+  for(int i = current.size() - 1; i >= 0; i--) {
+    if(std::find(rows.begin(), rows.end(), current[i]) == rows.end()) {
+      Element *child = current[i];
+      beginRemoveRows(index, i, i);
+      current.erase(current.begin() + i);
+      for(unsigned row = i; row < current.size(); row++) current[row]->treeviewRow = row;
+      endRemoveRows();
+
+      // its rows went with it, e.g. a node that lost its last region
+      child->treeChildren.clear();
+    }
+  }
+
+  // the remaining rows are in the same order as the children, new ones are merged in
+  for(unsigned i = 0; i < rows.size(); i++) {
+    if((i < current.size()) && (current[i] == rows[i])) continue;
+
+    // a node that just got its first region has no rows of its own yet
+    rows[i]->buildTreeChildren();
+
+    beginInsertRows(index, i, i);
+    current.insert(current.begin() + i, rows[i]);
+    for(unsigned row = i; row < current.size(); row++) current[row]->treeviewRow = row;
+    endInsertRows();
+  }
+}
+
+void Model::commitChanges() {
+  // no view refers to these anymore
+  for(auto element : detached) delete element;
+  for(auto edge : detachedEdges) delete edge;
+  detached.clear();
+  detachedEdges.clear();
+
+  std::vector<Element*> changed;
+  for(auto element : touched) {
+    if(isAttached(element)) changed.push_back(element);
+  }
+
+  // ports have no stats
+  for(auto element : added) {
+    if(isAttached(element) && (isNode(element) || element->isRegion())) computeSubtreeStats(element);
+  }
+
+  // tree rows, parents first so rows are only inserted below rows the view knows
+  // a parent whose node got or lost its regions changes the rows of its own parent
+  std::vector<Element*> treeParents;
+  for(auto element : changed) {
+    if(isNode(element) || element->isRegion() || (element == top)) treeParents.push_back(element);
+    if(element->parent) treeParents.push_back(element->parent);
+  }
+  std::sort(treeParents.begin(), treeParents.end());
+  treeParents.erase(std::unique(treeParents.begin(), treeParents.end()), treeParents.end());
+  std::stable_sort(treeParents.begin(), treeParents.end(), [](Element *a, Element *b) { return deeper(b, a); });
+  for(auto element : treeParents) {
+    refreshTreeRows(element);
+  }
+
+  // stats of the changed elements and everything above them, bottom-up
+  std::vector<Element*> statsChanged;
+  for(auto element : changed) {
+    for(Element *el = element; el; el = el->parent) statsChanged.push_back(el);
+  }
+  std::sort(statsChanged.begin(), statsChanged.end());
+  statsChanged.erase(std::unique(statsChanged.begin(), statsChanged.end()), statsChanged.end());
+  std::stable_sort(statsChanged.begin(), statsChanged.end(), deeper);
+  for(auto element : statsChanged) {
+    element->computeStats();
+  }
+
+  // regions whose vertices or edges changed are laid out again when drawn,
+  // the layouts of all other regions are kept
+  for(auto element : changed) {
+    if(element->isRegion()) ((Region*)element)->evictLayout();
+  }
+
+  highlights.update();
+
+  if(!added.empty() || !removed.empty() || !removedEdges.empty() || !touched.empty()) {
+    delete dataflow;
+    dataflow = NULL;
+  }
+
+  detached.swap(removed);
+  detachedEdges.swap(removedEdges);
+  touched.clear();
+  added.clear();
 }
 
 void Model::clearColors() {
-  top->clearColors();
+  highlights.clearAll();
+}
+
+/* copies view state (expanded nodes, highlight layers and region layering) from an
+   older model of the same file, elements are matched by id */
+void Model::transferState(Model *old) {
+  // highlighted edges, matched by source and target id
+  highlights.copySettings(old->highlights);
+  for(unsigned n = 0; n < old->edges.size(); n++) {
+    Edge *oldEdge = old->edges[n];
+
+    std::vector<unsigned> layers;
+    for(unsigned i = 0; i < highlights.size(); i++) {
+      if(old->highlights.getLayer(i).edges.contains(n)) layers.push_back(i);
+    }
+    if(layers.empty()) continue;
+
+    Element *el = getElement(oldEdge->source->id);
+    if(!el) continue;
+    for(auto edge : el->edges) {
+      if(edge->target->id == oldEdge->target->id) {
+        for(auto i : layers) highlights.mark(i, edge->number);
+      }
+    }
+  }
+
+  for(auto oldEl : old->vertices) {
+    Element *el = getElement(oldEl->id);
+    if(!el) continue;
+
+    if(oldEl->isComplexNode() && el->isComplexNode()) {
+      ((Node*)el)->setExpanded(((Node*)oldEl)->isExpanded());
+    }
+
+    if(oldEl->isRegion() && el->isRegion()) {
+      ((Region*)el)->reuseLayers((Region*)oldEl);
+    }
+  }
+}
+
+static void collectLevels(Element *element, unsigned depth, std::vector<std::vector<Element*> > &levels) {
+  if(levels.size() <= depth) levels.resize(depth + 1);
+  levels[depth].push_back(element);
+  for(auto child : element->children) {
+    collectLevels(child, depth + 1, levels);
+  }
+}
+
+/* applies function to all nodes and regions bottom-up
+   all elements at the same depth are independent and processed in parallel */
+void Model::mapBottomUp(void (*function)(Element*&)) {
+  std::vector<std::vector<Element*> > levels;
+  collectLevels(top, 0, levels);
+
+  for(auto level = levels.rbegin(); level != levels.rend(); level++) {
+    QtConcurrent::blockingMap(*level, function);
+  }
+}
+
+static void computeHash(Element *&element) {
+  element->computeHash();
+}
+
+static void computeStats(Element *&element) {
+  element->computeStats();
+}
+
+void Model::computeHashes() {
+  mapBottomUp(computeHash);
+}
+
+void Model::computeStats() {
+  mapBottomUp(::computeStats);
+}
+
+void Model::clearDiff() {
+  top->diffState = DIFF_NONE;
+  for(auto el : vertices) {
+    el->diffState = DIFF_NONE;
+  }
+}
+
+/* reads an RVSDG file and builds the model, returns NULL and sets error on failure
+   does not touch the GUI, so it may run in a background thread */
+Model *readModel(const QString &fileName, QString &error) {
+  QDomDocument doc;
+
+  // compressed files are decompressed in a separate thread while parsing
+  Compression compression = DecompressDevice::detect(fileName);
+  QScopedPointer<QIODevice> file;
+  if(compression == COMPRESSION_NONE) {
+    file.reset(new QFile(fileName));
+  } else {
+    file.reset(new DecompressDevice(fileName, compression));
+  }
+
+  if(!file->open(QIODevice::ReadOnly)) {
+    error = (compression == COMPRESSION_NONE) ? QString("File not found") : file->errorString();
+    return NULL;
+  }
+  if(!doc.setContent(file.data())) {
+    if((compression != COMPRESSION_NONE) && ((DecompressDevice*)file.data())->failed()) {
+      error = file->errorString();
+    } else {
+      error = "Invalid XML file";
+    }
+    file->close();
+    return NULL;
+  }
+  file->close();
+
+  try {
+    Model *model = new Model(doc);
+    MemoryReport::samplePeak("load"); // the DOM is still alive here
+    return model;
+  } catch (std::exception &e) {
+    error = "Invalid RVSDG file";
+    return NULL;
+  }
 }
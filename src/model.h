@@ -18,18 +18,44 @@
 #include <QGraphicsPolygonItem>
 
 #include "element.h"
+#include "dataflow.h"
+#include "highlight.h"
+
+class Region;
 
 class Model : public QAbstractItemModel {
   Q_OBJECT
 
-  std::map<QString,Element*> elements;
+  QHash<QString,Element*> elements; // id index
+  std::vector<Element*> vertices;
+  std::vector<Edge*> edges; // by edge number
+  std::vector<Region*> regions;
   Element *top;
+  Dataflow *dataflow; // NULL after live updates, until it is needed again
+  Highlights highlights;
+
+  // live updates since the last commitChanges()
+  std::vector<Element*> touched;      // elements whose children, ports or edges changed
+  std::vector<Element*> added;        // roots of added subtrees
+  std::vector<Element*> removed;      // roots of removed subtrees
+  std::vector<Edge*> removedEdges;
+  // removed by the last commit, deleted by the next one so views can let go of them first
+  std::vector<Element*> detached;
+  std::vector<Edge*> detachedEdges;
+
+  void buildIndex();
+  void mapBottomUp(void (*function)(Element*&));
+
+  void appendVertex(Element *element);
+  void dropVertex(Element *element);
+  void appendEdgeNumber(Edge *edge);
+  void dropEdge(Edge *edge);
+  void touchPort(Element *port);
+  void refreshTreeRows(Element *parent);
 
 public:  
   Model(const QDomDocument &doc, QObject *parent = 0);
-  ~Model() {
-    delete top;
-  }
+  ~Model();
 
   QModelIndex index(int treeviewRow, int column, const QModelIndex &parent) const;
   QModelIndex parent(const QModelIndex &index) const;
@@ -39,6 +65,57 @@ public:
   QVariant headerData(int section, Qt::Orientation orientation, int role) const;
   Qt::ItemFlags flags(const QModelIndex &index) const;
   void clearColors();
+  Dataflow *getDataflow() {
+    if(!dataflow) dataflow = new Dataflow(vertices);
+    return dataflow;
+  }
+  Highlights *getHighlights() {
+    return &highlights;
+  }
+  const std::vector<Element*> &getVertices() {
+    return vertices;
+  }
+  QModelIndex indexOf(Element *element) const;
+  Element *getElement(const QString &id) {
+    return elements.value(id, NULL);
+  }
+  void transferState(Model *old);
+  Element *getTop() {
+    return top;
+  }
+  void computeHashes();
+  void computeStats();
+  void clearDiff();
+  void rebuildIndex();
+  void renumber();
+
+  /* live updates, applied in place and made visible by commitChanges()
+     each returns false if the update does not fit the graph and was ignored */
+
+  /* adds element and its subtree, as read from a file, below parentId or below
+     the top when parentId is empty, edges within the subtree are added too */
+  bool addElement(const QString &parentId, const QDomElement &element);
+  /* removes an element, its subtree and all edges to and from it */
+  bool removeElement(const QString &id);
+  /* sets the name or type of a node */
+  bool modifyElement(const QString &id, const QString &key, const QString &value);
+  bool addEdge(const QString &source, const QString &target);
+  bool removeEdge(const QString &source, const QString &target);
+
+  /* updates the tree view rows, stats and layouts of the elements touched since the
+     last commit, the rest of the model is left as it is */
+  void commitChanges();
+  /* false for elements removed by the last commit, which stay allocated until the next */
+  bool isAttached(Element *element);
+
+  /* bytes held by the layouts of all regions */
+  quint64 getLayoutMemory();
+  /* evicts the layouts of regions not in the current draw, least recently drawn
+     first, until at most budget bytes are left */
+  void evictLayouts(quint64 budget);
 };
 
+/* reads an RVSDG file, plain or compressed, returns NULL and sets error on failure */
+Model *readModel(const QString &fileName, QString &error);
+
 #endif
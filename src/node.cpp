@@ -1,10 +1,14 @@
 #include <stdio.h>
 #include <QDebug>
 #include <QBrush>
+#include <QPen>
 
 #include "node.h"
 #include "input.h"
 #include "output.h"
+#include "region.h"
+#include "dataflow.h"
+#include "stats.h"
 
 Element *Node::parseXmlElement(QString tagName, QString childId) {
   Element *child = this;
@@ -38,10 +42,9 @@ unsigned Node::getNumEdges() {
   return totalSize;
 }
 
-Edge *Node::getEdge(unsigned n, Element **source) {
+Edge *Node::getEdge(unsigned n) {
   for(auto it : outputs) {
     if(n < it->getNumEdges()) {
-      if(source) *source = it;
       return it->getEdge(n);
     }
     n -= it->getNumEdges();
@@ -58,6 +61,80 @@ void Node::setLineSegments(unsigned n, std::vector<LineSegment>lines) {
   }
 }
 
+/* links ports positionally, aligned at the end of both vectors
+   surplus ports at the start of "from" (e.g. the gamma predicate) are linked to all of "to" */
+static void appendPortLinks(std::vector<Element*> &from, std::vector<Element*> &to, std::vector<FlowLink> &links) {
+  int offset = (int)from.size() - (int)to.size();
+  for(int i = 0; i < (int)from.size(); i++) {
+    if(i < offset) {
+      for(auto port : to) {
+        links.push_back(FlowLink(from[i]->number, port->number, NULL));
+      }
+    } else {
+      links.push_back(FlowLink(from[i]->number, to[i - offset]->number, NULL));
+    }
+  }
+}
+
+void Node::appendFlowLinks(std::vector<FlowLink> &links, bool forward) {
+  Element::appendFlowLinks(links, forward);
+
+  if(isSimpleNode()) {
+    // values flow from all inputs to all outputs, through the node itself
+    for(auto input : inputs) {
+      links.push_back(FlowLink(input->number, number, NULL));
+    }
+    for(auto output : outputs) {
+      links.push_back(FlowLink(number, output->number, NULL));
+    }
+
+  } else {
+    // values flow into the regions through arguments and out through results
+    for(auto child : children) {
+      Region *region = (Region*)child;
+      appendPortLinks(inputs, region->arguments, links);
+      appendPortLinks(region->results, outputs, links);
+      if(type == THETA) {
+        appendPortLinks(region->results, region->arguments, links);
+      }
+    }
+  }
+}
+
+void Node::computeHash() {
+  quint64 h = hashCombine(type, qHash(name));
+  h = hashCombine(h, inputs.size());
+  h = hashCombine(h, outputs.size());
+  for(auto child : children) {
+    h = hashCombine(h, child->hash);
+  }
+  hash = h;
+}
+
+void Node::computeStats() {
+  Element::computeStats();
+  stats->nodes[type]++;
+  stats->area += ESTIMATED_NODE_AREA;
+
+  // a node counts as one step on a path, or as the longest path through its regions
+  if(stats->longestPath < 1) stats->longestPath = 1;
+}
+
+QColor Node::getColor() {
+  switch(type) {
+    case LAMBDA:
+      return QColor(LAMBDA_NODE_COLOR);
+    case GAMMA:
+      return QColor(GAMMA_NODE_COLOR);
+    case THETA:
+      return QColor(THETA_NODE_COLOR);
+    case PHI:
+      return QColor(PHI_NODE_COLOR);
+    default:
+      return QColor(NODE_COLOR);
+  }
+}
+
 QString Node::getTypeName() {
   switch(type) {
     case LAMBDA: 
@@ -84,26 +161,15 @@ void Node::appendItems(QGraphicsItem *parent) {
   height = 0;
 
   // create base item (rectangle)
-  baseItem = new QGraphicsPolygonItem(parent);
+  baseItem = ItemPool::polygon(parent);
   baseItem->setPos(QPointF(x, y));
   baseItem->setData(0, QVariant::fromValue((void*)this));
 
-  switch(type) {
-    case LAMBDA:
-      baseItem->setBrush(QBrush(QColor(LAMBDA_NODE_COLOR)));
-      break;
-    case GAMMA:
-      baseItem->setBrush(QBrush(QColor(GAMMA_NODE_COLOR)));
-      break;
-    case THETA:
-      baseItem->setBrush(QBrush(QColor(THETA_NODE_COLOR)));
-      break;
-    case PHI:
-      baseItem->setBrush(QBrush(QColor(PHI_NODE_COLOR)));
-      break;
-    default:
-      baseItem->setBrush(QBrush(QColor(NODE_COLOR)));
-      break;
+  baseItem->setBrush(QBrush(getColor()));
+
+  QColor diffColor;
+  if(getDiffColor(diffColor)) {
+    baseItem->setPen(QPen(diffColor, DIFF_PEN_WIDTH));
   }
 
   // create input items
@@ -121,7 +187,7 @@ void Node::appendItems(QGraphicsItem *parent) {
   // create name text
   xx = TEXT_CLEARANCE;
   yy += TEXT_CLEARANCE;
-  QGraphicsTextItem *text = new QGraphicsTextItem(name, baseItem);
+  QGraphicsTextItem *text = ItemPool::text(name, baseItem);
   text->setPos(QPointF(xx, yy));
   text->setData(0, QVariant::fromValue((void*)this));
   unsigned textwidth = text->boundingRect().width() + TEXT_CLEARANCE*2;
@@ -131,7 +197,7 @@ void Node::appendItems(QGraphicsItem *parent) {
   // create id text
   xx = TEXT_CLEARANCE;
   yy += TEXT_CLEARANCE;
-  text = new QGraphicsTextItem(id, baseItem);
+  text = ItemPool::text(id, baseItem);
   text->setPos(QPointF(xx, yy));
   text->setData(0, QVariant::fromValue((void*)this));
   textwidth = text->boundingRect().width() + TEXT_CLEARANCE*2;
@@ -149,11 +215,15 @@ void Node::appendItems(QGraphicsItem *parent) {
 
     for(auto child : children) {
       // create a rectangle for the child region
-      QGraphicsPolygonItem *poly = new QGraphicsPolygonItem(baseItem);
+      QGraphicsPolygonItem *poly = ItemPool::polygon(baseItem);
       poly->setBrush(QBrush(QColor(Qt::white)));
+      if(child->getDiffColor(diffColor)) {
+        poly->setPen(QPen(diffColor, DIFF_PEN_WIDTH));
+      }
     
       // create child region
       child->appendItems(poly);
+      child->setPos(xx, yy);
       poly->setPos(xx, yy);
 
       // update position variables
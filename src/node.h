@@ -15,13 +15,23 @@ enum NodeType {
   NODE, LAMBDA, GAMMA, THETA, PHI
 };
 
+#define NUM_NODE_TYPES (PHI+1)
+
+/* node type from the type attribute of a node, plain nodes have none */
+inline NodeType parseNodeType(const QString &name) {
+  if(name == "lambda") return LAMBDA;
+  if(name == "gamma") return GAMMA;
+  if(name == "theta") return THETA;
+  if(name == "phi") return PHI;
+  return NODE;
+}
+
 class Node : public Element {
 
   unsigned width;
   unsigned height;
   QString name;
   NodeType type;
-  QGraphicsPolygonItem *baseItem;
   bool expanded;
 
 public:
@@ -58,11 +68,7 @@ public:
 
   unsigned getNumEdges();
 
-  Edge *getEdge(unsigned n) {
-    return getEdge(n, NULL);
-  }
-
-  Edge *getEdge(unsigned n, Element **source);
+  Edge *getEdge(unsigned n);
 
   void setLineSegments(unsigned n, std::vector<LineSegment>lines);
 
@@ -77,6 +83,33 @@ public:
 
   QString getTypeName();
 
+  QColor getColor();
+
+  NodeType getType() {
+    return type;
+  }
+  void setType(NodeType type) {
+    this->type = type;
+  }
+
+  QString getName() {
+    return name;
+  }
+  void setName(const QString &name) {
+    this->name = name;
+  }
+
+  void getPorts(std::vector<Element*> &ports) {
+    ports.insert(ports.end(), inputs.begin(), inputs.end());
+    ports.insert(ports.end(), outputs.begin(), outputs.end());
+  }
+
+  void appendFlowLinks(std::vector<FlowLink> &links, bool forward);
+
+  void computeHash();
+
+  void computeStats();
+
   //---------------------------------------------------------------------------
   // graphical information, used when drawing
 
@@ -84,6 +117,14 @@ public:
     expanded = !expanded;
   }
 
+  void setExpanded(bool expanded) {
+    this->expanded = expanded;
+  }
+
+  bool isExpanded() {
+    return expanded;
+  }
+
   void setPos(unsigned x, unsigned y) {
     Element::setPos(x, y);
     baseItem->setPos(x, y);
@@ -97,16 +138,6 @@ public:
   }
 
   void appendItems(QGraphicsItem *item);
-
-  virtual void clearColors() {
-    Element::clearColors();
-    for(auto child : inputs) {
-      child->clearColors();
-    }
-    for(auto child : outputs) {
-      child->clearColors();
-    }
-  }
 };
 
 #endif
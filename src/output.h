@@ -12,19 +12,11 @@
 #include "element.h"
 
 class Output : public Element {
-  QGraphicsPolygonItem *baseItem;
-
 public:
   Output(QString id, Element *parent) : Element(id, 0, parent) {}
   Element *getVertex() {
     return parent;
   }
-  unsigned getRow() {
-    return parent->getRow();
-  }
-  unsigned getColumn() {
-    return parent->getColumn();
-  }
   unsigned getX() {
     return parent->getX() + x;
   }
@@ -44,7 +36,7 @@ public:
     polygon << QPointF(0,0)
             << QPointF(-INPUTOUTPUT_SIZE/2,-INPUTOUTPUT_SIZE)
             << QPointF(INPUTOUTPUT_SIZE/2,-INPUTOUTPUT_SIZE);
-    baseItem = new QGraphicsPolygonItem(polygon, parent);
+    baseItem = ItemPool::polygon(polygon, parent);
     baseItem->setData(0, QVariant::fromValue((void*)this));
   }
   void setPos(unsigned x, unsigned y) {
@@ -0,0 +1,149 @@
+#include <cmath>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "profile.h"
+
+unsigned Profile::addMetric(const QString &name, unsigned numElements) {
+  metrics << name;
+  values.push_back(std::vector<float>(numElements, NAN));
+  return values.size() - 1;
+}
+
+bool Profile::loadCsv(const QByteArray &data, Model *model, QString &error) {
+  unsigned numElements = model->getVertices().size();
+
+  int pos = 0;
+  bool header = true;
+
+  while(pos < data.size()) {
+    int end = data.indexOf('\n', pos);
+    if(end < 0) end = data.size();
+    QByteArray line = data.mid(pos, end - pos).trimmed();
+    pos = end + 1;
+
+    if(line.isEmpty()) continue;
+
+    QList<QByteArray> fields = line.split(',');
+
+    if(header) {
+      if(fields.size() < 2) {
+        error = "Expected header line with id and at least one metric";
+        return false;
+      }
+      for(int i = 1; i < fields.size(); i++) {
+        addMetric(QString::fromUtf8(fields[i].trimmed()), numElements);
+      }
+      header = false;
+      continue;
+    }
+
+    rows++;
+
+    Element *element = model->getElement(QString::fromUtf8(fields[0].trimmed()));
+    if(!element) continue;
+    matched++;
+
+    for(int i = 1; (i < fields.size()) && ((unsigned)i <= values.size()); i++) {
+      bool ok;
+      float value = fields[i].trimmed().toFloat(&ok);
+      if(ok) values[i-1][element->number] = value;
+    }
+  }
+
+  return true;
+}
+
+bool Profile::loadJson(const QByteArray &data, Model *model, QString &error) {
+  unsigned numElements = model->getVertices().size();
+
+  QJsonParseError parseError;
+  QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+  if(!doc.isObject()) {
+    error = parseError.errorString();
+    return false;
+  }
+
+  QHash<QString,unsigned> metricIndex;
+  QJsonObject object = doc.object();
+
+  for(auto it = object.begin(); it != object.end(); it++) {
+    rows++;
+
+    Element *element = model->getElement(it.key());
+    if(!element) continue;
+    matched++;
+
+    if(it.value().isDouble()) {
+      if(!metricIndex.contains("value")) metricIndex["value"] = addMetric("value", numElements);
+      values[metricIndex["value"]][element->number] = it.value().toDouble();
+
+    } else if(it.value().isObject()) {
+      QJsonObject elementMetrics = it.value().toObject();
+      for(auto m = elementMetrics.begin(); m != elementMetrics.end(); m++) {
+        if(!m.value().isDouble()) continue;
+        if(!metricIndex.contains(m.key())) metricIndex[m.key()] = addMetric(m.key(), numElements);
+        values[metricIndex[m.key()]][element->number] = m.value().toDouble();
+      }
+    }
+  }
+
+  return true;
+}
+
+bool Profile::load(const QString &fileName, Model *model, QString &error) {
+  QFile file(fileName);
+  if(!file.open(QIODevice::ReadOnly)) {
+    error = "File not found";
+    return false;
+  }
+  QByteArray data = file.readAll();
+  file.close();
+
+  bool ok;
+  if(fileName.endsWith(".json", Qt::CaseInsensitive)) {
+    ok = loadJson(data, model, error);
+  } else {
+    ok = loadCsv(data, model, error);
+  }
+  if(!ok) return false;
+
+  // find ranges, used for normalizing
+  for(auto &metricValues : values) {
+    float minValue = INFINITY;
+    float maxValue = -INFINITY;
+    for(auto value : metricValues) {
+      if(std::isnan(value)) continue;
+      if(value < minValue) minValue = value;
+      if(value > maxValue) maxValue = value;
+    }
+    minValues.push_back(minValue);
+    maxValues.push_back(maxValue);
+  }
+
+  return true;
+}
+
+bool Profile::getHeat(unsigned metric, Element *element, float &heat) {
+  if(metric >= values.size()) return false;
+
+  std::vector<float> &metricValues = values[metric];
+  if(element->number >= metricValues.size()) return false;
+
+  float value = metricValues[element->number];
+  if(std::isnan(value)) {
+    Element *vertex = element->getVertex();
+    if((vertex == element) || (vertex->number >= metricValues.size())) return false;
+    value = metricValues[vertex->number];
+    if(std::isnan(value)) return false;
+  }
+
+  float range = maxValues[metric] - minValues[metric];
+  if(range <= 0) {
+    heat = 1;
+  } else {
+    heat = std::log1p(value - minValues[metric]) / std::log1p(range);
+  }
+  return true;
+}
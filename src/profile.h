@@ -0,0 +1,45 @@
+/******************************************************************************
+ *
+ * Per element metrics (e.g. runtime or instruction counts) from a sidecar file
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <vector>
+#include <QString>
+#include <QStringList>
+
+#include "model.h"
+
+class Profile {
+  std::vector<std::vector<float> > values; // per metric, indexed by element number, NaN if missing
+  std::vector<float> minValues;
+  std::vector<float> maxValues;
+
+  unsigned addMetric(const QString &name, unsigned numElements);
+  bool loadCsv(const QByteArray &data, Model *model, QString &error);
+  bool loadJson(const QByteArray &data, Model *model, QString &error);
+
+public:
+  QStringList metrics;
+  unsigned rows;    // rows in file
+  unsigned matched; // rows matching an element
+
+  Profile() {
+    rows = matched = 0;
+  }
+
+  /* reads a CSV file (header "id,metric,...") or a JSON file ({"id": value} or
+     {"id": {"metric": value, ...}}) and joins it with the elements of model */
+  bool load(const QString &fileName, Model *model, QString &error);
+
+  /* value of metric for element, normalized to 0..1 on a log scale
+     elements without a value of their own use the value of their vertex */
+  bool getHeat(unsigned metric, Element *element, float &heat);
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+
+#include "query.h"
+#include "region.h"
+#include "stats.h"
+
+static const char *typeNames[NUM_NODE_TYPES] = {
+  "node", "lambda", "gamma", "theta", "phi"
+};
+
+static bool parseType(const QString &name, NodeType &type) {
+  for(unsigned i = 0; i < NUM_NODE_TYPES; i++) {
+    if(name == typeNames[i]) {
+      type = (NodeType)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static QJsonObject nodeObject(Node *node) {
+  QJsonObject object;
+  object["id"] = node->id;
+  object["type"] = typeNames[node->getType()];
+  if(!node->getName().isEmpty()) object["name"] = node->getName();
+  return object;
+}
+
+/* appends all nodes below element, in tree order */
+static void collectNodes(Element *element, std::vector<Node*> &nodes) {
+  for(auto child : element->children) {
+    if(!child->isRegion()) nodes.push_back((Node*)child);
+    collectNodes(child, nodes);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Query::evaluate(const QString &expression, QJsonObject &result, QString &error) {
+  QStringList words = expression.simplified().split(' ', Qt::SkipEmptyParts);
+
+  result["query"] = expression.trimmed();
+
+  // optional scope
+  Element *root = model->getTop();
+  if((words.size() >= 2) && (words[words.size()-2] == "under")) {
+    root = model->getElement(words.last());
+    if(!root) {
+      error = "Unknown element " + words.last();
+      return false;
+    }
+    result["under"] = root->id;
+    words.removeLast();
+    words.removeLast();
+  }
+
+  if(words.isEmpty()) {
+    error = "Empty query";
+    return false;
+  }
+
+  if((words[0] == "count") && (words.size() == 1)) {
+    return count(root, result, error);
+  }
+
+  if((words[0] == "fanout") && (words.size() == 3) && (words[1] == ">")) {
+    bool ok;
+    unsigned threshold = words[2].toUInt(&ok);
+    if(ok) return fanout(root, threshold, result);
+  }
+
+  if((words[0] == "nested") && (words.size() == 4) && (words[2] == "in")) {
+    NodeType inner, outer;
+    if(parseType(words[1], inner) && parseType(words[3], outer)) {
+      return nested(root, inner, outer, result);
+    }
+    error = "Node types are node, lambda, gamma, theta and phi";
+    return false;
+  }
+
+  if((words[0] == "longest-path") && (words.size() == 2)) {
+    Element *region = model->getElement(words[1]);
+    if(!region) {
+      error = "Unknown element " + words[1];
+      return false;
+    }
+    return longestPath(region, result, error);
+  }
+
+  error = "Unknown query, expected count, fanout > <n>, nested <type> in <type> or longest-path <region>";
+  return false;
+}
+
+/* from the subtree stats, computed when the model was built */
+bool Query::count(Element *root, QJsonObject &result, QString &error) {
+  if(!root->stats) {
+    error = root->id + " is a port";
+    return false;
+  }
+
+  QJsonObject types;
+  for(unsigned i = 0; i < NUM_NODE_TYPES; i++) {
+    types[typeNames[i]] = (int)root->stats->nodes[i];
+  }
+
+  result["nodes"] = (int)root->stats->getNumNodes();
+  result["types"] = types;
+  result["edges"] = (int)root->stats->edges;
+
+  return true;
+}
+
+/* the fanout of a node is the number of edges from its outputs, read from the dataflow index */
+bool Query::fanout(Element *root, unsigned threshold, QJsonObject &result) {
+  std::vector<Node*> nodes;
+  collectNodes(root, nodes);
+
+  Dataflow *dataflow = model->getDataflow();
+
+  QJsonArray hits;
+  for(auto node : nodes) {
+    unsigned fanout = 0;
+    for(auto output : node->outputs) {
+      fanout += dataflow->getNumSuccessors(output);
+    }
+    if(fanout > threshold) {
+      QJsonObject object = nodeObject(node);
+      object["fanout"] = (int)fanout;
+      hits.append(object);
+    }
+  }
+
+  result["nodes"] = hits;
+  return true;
+}
+
+bool Query::nested(Element *root, NodeType inner, NodeType outer, QJsonObject &result) {
+  std::vector<Node*> nodes;
+  collectNodes(root, nodes);
+
+  QJsonArray hits;
+  for(auto node : nodes) {
+    if(node->getType() != inner) continue;
+
+    // nearest enclosing node of the outer type, within the scope and including it,
+    // the document root has no parent and is not a node
+    for(Element *el = node->parent; el && el->parent; el = el->parent) {
+      if(!el->isRegion() && (((Node*)el)->getType() == outer)) {
+        QJsonObject object = nodeObject(node);
+        object["in"] = el->id;
+        hits.append(object);
+        break;
+      }
+      if(el == root) break;
+    }
+  }
+
+  result["nodes"] = hits;
+  return true;
+}
+
+bool Query::longestPath(Element *region, QJsonObject &result, QString &error) {
+  if(!region->isRegion()) {
+    error = region->id + " is not a region";
+    return false;
+  }
+
+  std::vector<Element*> path;
+  ((Region*)region)->computePathStats(&path);
+
+  QJsonArray ids;
+  for(auto node : path) {
+    ids.append(node->id);
+  }
+
+  result["length"] = (int)region->stats->longestPath;
+  result["ids"] = ids;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int Query::run(const QString &fileName, const QString &expressions) {
+  QTextStream out(stdout);
+  QJsonObject output;
+  output["file"] = fileName;
+
+  QString error;
+  Model *model = readModel(fileName, error);
+  if(!model) {
+    output["error"] = error;
+    out << QJsonDocument(output).toJson(QJsonDocument::Compact) << "\n";
+    return 1;
+  }
+
+  Query query(model);
+  QJsonArray results;
+  bool ok = true;
+
+  for(auto segment : expressions.split(';')) {
+    // whitespace between or after the separators is not a query
+    QString expression = segment.trimmed();
+    if(expression.isEmpty()) continue;
+
+    QJsonObject result;
+    if(!query.evaluate(expression, result, error)) {
+      result["error"] = error;
+      ok = false;
+    }
+    results.append(result);
+  }
+
+  output["results"] = results;
+  out << QJsonDocument(output).toJson(QJsonDocument::Compact) << "\n";
+
+  delete model;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+/******************************************************************************
+ *
+ * Graph queries, evaluated without the GUI and answered as JSON
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <vector>
+#include <QString>
+#include <QJsonObject>
+
+#include "model.h"
+#include "node.h"
+
+/* Query syntax, every query but longest-path may be limited to a subtree
+   by appending "under <id>":
+
+     count                           nodes by type and edges
+     fanout > <n>                    nodes with more than n outgoing edges
+     nested <type> in <type>         nodes of one type inside a node of another,
+                                     e.g. "nested theta in gamma"
+     longest-path <region id>        ids of the nodes on the longest dataflow path
+
+   Stats, the id index and the dataflow index are all built when the model
+   is loaded, so queries only visit the elements they report on. */
+class Query {
+  Model *model;
+
+  bool count(Element *root, QJsonObject &result, QString &error);
+  bool fanout(Element *root, unsigned threshold, QJsonObject &result);
+  bool nested(Element *root, NodeType inner, NodeType outer, QJsonObject &result);
+  bool longestPath(Element *region, QJsonObject &result, QString &error);
+
+public:
+  Query(Model *model) {
+    this->model = model;
+  }
+
+  /* evaluates one query, returns false and sets error if it is not valid */
+  bool evaluate(const QString &expression, QJsonObject &result, QString &error);
+
+  /* loads fileName and prints the results of the ';' separated queries as JSON,
+     returns the process exit code */
+  static int run(const QString &fileName, const QString &expressions);
+};
+
+#endif
@@ -1,14 +1,43 @@
 #include <stdio.h>
 #include <QDebug>
 #include <QPen>
+#include <QHash>
+#include <QBrush>
+#include <algorithm>
+#include <unordered_map>
 
 #include "element.h"
 #include "region.h"
 #include "argument.h"
 #include "result.h"
 #include "edge.h"
-
-extern QColor edgeColors[];
+#include "node.h"
+#include "stats.h"
+
+unsigned Region::drawBudget = SUMMARY_BUDGET;
+unsigned Region::drawStamp = 1;
+std::vector<unsigned> Region::positionsX;
+std::vector<unsigned> Region::positionsY;
+std::vector<unsigned> Region::slotOf;
+
+/* stores the final coordinates of all vertices and their ports, so that routing
+   does not go through the parent chain of every port for every edge */
+void Region::storePositions() {
+  for(auto vertex : slotVertices) {
+    std::vector<Element*> ports;
+    ports.push_back(vertex);
+    vertex->getPorts(ports);
+
+    for(auto port : ports) {
+      if(port->number >= positionsX.size()) {
+        positionsX.resize(port->number + 1);
+        positionsY.resize(port->number + 1);
+      }
+      positionsX[port->number] = port->getX();
+      positionsY[port->number] = port->getY();
+    }
+  }
+}
 
 Element *Region::parseXmlElement(QString tagName, QString childId) {
   Element *child = this;
@@ -25,6 +54,116 @@ Element *Region::parseXmlElement(QString tagName, QString childId) {
   return child;
 }
 
+/******************************************************************************
+ * layering cache
+ * regions with the same shape get the same layering, so it is only computed
+ * once per shape and stamped onto the other regions
+ *****************************************************************************/
+
+class CachedShape {
+public:
+  ShapeKey key;    // compared on a hit, as different shapes may share a hash
+  LayerShape shape;
+  unsigned lastUsed; // drawStamp of the last region stamped with this shape
+};
+
+static std::unordered_map<quint64,CachedShape> layerCache;
+
+static quint64 shapeMemory(const CachedShape &cached) {
+  quint64 bytes = sizeof(quint64) + sizeof(CachedShape) + cached.key.capacity() * sizeof(unsigned)
+    + cached.shape.capacity() * sizeof(std::vector<unsigned>);
+  for(auto &layer : cached.shape) {
+    bytes += layer.capacity() * sizeof(unsigned);
+  }
+  return bytes;
+}
+
+quint64 Region::getLayerCacheMemory() {
+  quint64 bytes = 0;
+  for(auto &entry : layerCache) {
+    bytes += shapeMemory(entry.second);
+  }
+  return bytes;
+}
+
+/* drops the least recently used shapes until the cache fits in budget bytes */
+void Region::trimLayerCache(quint64 budget) {
+  std::vector<std::pair<unsigned,quint64> > entries; // last used, shape
+  quint64 bytes = 0;
+  for(auto &entry : layerCache) {
+    entries.push_back(std::make_pair(entry.second.lastUsed, entry.first));
+    bytes += shapeMemory(entry.second);
+  }
+  std::sort(entries.begin(), entries.end());
+
+  for(auto &entry : entries) {
+    if((bytes <= budget) || (entry.first == drawStamp)) break;
+    auto it = layerCache.find(entry.second);
+    bytes -= shapeMemory(it->second);
+    layerCache.erase(it);
+  }
+}
+
+/* hash of the region as seen by the layering algorithm: the number of vertices
+   and the edges between them, ignoring ids, names and the contents of nodes
+   fills vertices with arguments, children and results, in that order, and key with
+   the exact shape */
+quint64 Region::shapeHash(std::vector<Element*> &vertices, ShapeKey &key) {
+  vertices.insert(vertices.end(), arguments.begin(), arguments.end());
+  vertices.insert(vertices.end(), children.begin(), children.end());
+  vertices.insert(vertices.end(), results.begin(), results.end());
+
+  std::unordered_map<Element*,unsigned> vertexIndex;
+  for(unsigned i = 0; i < vertices.size(); i++) {
+    vertexIndex[vertices[i]] = i;
+  }
+
+  key.push_back(arguments.size());
+  key.push_back(children.size());
+  key.push_back(results.size());
+  for(unsigned i = 0; i < vertices.size(); i++) {
+    for(unsigned e = 0; e < vertices[i]->getNumEdges(); e++) {
+      auto it = vertexIndex.find(vertices[i]->getEdge(e)->target->getVertex());
+      key.push_back(i);
+      key.push_back((it != vertexIndex.end()) ? it->second : ~0U);
+    }
+  }
+
+  quint64 hash = hashCombine(hashCombine(key[0], key[1]), key[2]);
+  for(unsigned i = 3; i < key.size(); i++) {
+    hash = hashCombine(hash, key[i]);
+  }
+
+  return hash;
+}
+
+void Region::stampLayers(const LayerShape &shape, const std::vector<Element*> &vertices) {
+  for(auto &shapeLayer : shape) {
+    std::vector<Element*> *layer = new std::vector<Element*>;
+    for(auto index : shapeLayer) {
+      layer->push_back(vertices[index]);
+    }
+    layers.push_back(layer);
+  }
+}
+
+void Region::cacheLayers(quint64 shape, ShapeKey &key, const std::vector<Element*> &vertices) {
+  std::unordered_map<Element*,unsigned> vertexIndex;
+  for(unsigned i = 0; i < vertices.size(); i++) {
+    vertexIndex[vertices[i]] = i;
+  }
+
+  CachedShape &cached = layerCache[shape];
+  cached.key.swap(key);
+  cached.lastUsed = drawStamp;
+  for(auto layer : layers) {
+    cached.shape.push_back(std::vector<unsigned>());
+    for(auto vertex : *layer) {
+      cached.shape.back().push_back(vertexIndex[vertex]);
+    }
+  }
+}
+
 /******************************************************************************
  * longest path layering algorithm
  * builds the layers bottom-up (layer 0 is bottom layer)
@@ -33,6 +172,19 @@ void Region::layer() {
 
   if(!layers.size()) { // don't rebuild unnecessary
 
+    std::vector<Element*> vertices;
+    ShapeKey key;
+    quint64 shape = shapeHash(vertices, key);
+
+    // on a hash collision the region is layered without the cache
+    auto cached = layerCache.find(shape);
+    bool collision = (cached != layerCache.end()) && (cached->second.key != key);
+    if((cached != layerCache.end()) && !collision) {
+      cached->second.lastUsed = drawStamp;
+      stampLayers(cached->second.shape, vertices);
+      return;
+    }
+
     std::vector<Element*> unassignedNodes = children;
     std::vector<Element*> assignedNodes;
     std::vector<Element*> nodesBelowCurrent;
@@ -45,7 +197,6 @@ void Region::layer() {
     layers.push_back(new std::vector<Element*>);
 
     for(auto node = results.begin(); node != results.end(); node++) {
-      (*node)->setRowCol(currentLayer, layers[currentLayer]->size());
       layers[currentLayer]->push_back(*node);
       nodesBelowCurrent.push_back(*node);
     }
@@ -62,7 +213,6 @@ void Region::layer() {
           layers.push_back(new std::vector<Element*>);
         }
 
-        (*node)->setRowCol(currentLayer, layers[currentLayer]->size());
 
         layers[currentLayer]->push_back(*node);
         assignedNodes.push_back(*node);
@@ -97,7 +247,6 @@ void Region::layer() {
             layers.push_back(new std::vector<Element*>);
           }
 
-          (*node)->setRowCol(currentLayer, layers[currentLayer]->size());
 
           layers[currentLayer]->push_back(*node);
           assignedNodes.push_back(*node);
@@ -123,10 +272,198 @@ void Region::layer() {
       currentLayer++;
       layers.push_back(new std::vector<Element*>);
       for(auto node = arguments.begin(); node != arguments.end(); node++) {
-        (*node)->setRowCol(currentLayer, layers[currentLayer]->size());
         layers[currentLayer]->push_back(*node);
       }
     }
+
+    if(!collision) cacheLayers(shape, key, vertices);
+  }
+}
+
+/* hash of the ids of all vertices in this region and the targets of their edges
+   two regions with the same signature get the same layering */
+quint64 Region::signature() {
+  quint64 hash = children.size() * 31 + arguments.size() * 7 + results.size();
+
+  for(auto vertices : { &arguments, &children, &results }) {
+    for(auto vertex : *vertices) {
+      hash = hash * 31 + qHash(vertex->id);
+      for(unsigned i = 0; i < vertex->getNumEdges(); i++) {
+        hash = hash * 31 + qHash(vertex->getEdge(i)->target->id);
+      }
+    }
+  }
+
+  return hash;
+}
+
+/* takes over the layering of an older version of this region, if it is unchanged */
+void Region::reuseLayers(Region *old) {
+  if(layers.size() || !old->layers.size()) return;
+
+  if((children.size() != old->children.size()) ||
+     (arguments.size() != old->arguments.size()) ||
+     (results.size() != old->results.size()) ||
+     (signature() != old->signature())) {
+    return;
+  }
+
+  // the signatures match, so vertices pair up by position
+  std::map<Element*,Element*> vertexMap;
+  for(unsigned i = 0; i < children.size(); i++) vertexMap[old->children[i]] = children[i];
+  for(unsigned i = 0; i < arguments.size(); i++) vertexMap[old->arguments[i]] = arguments[i];
+  for(unsigned i = 0; i < results.size(); i++) vertexMap[old->results[i]] = results[i];
+
+  for(auto oldLayer : old->layers) {
+    std::vector<Element*> *layer = new std::vector<Element*>;
+    for(auto oldVertex : *oldLayer) {
+      Element *vertex = vertexMap[oldVertex];
+      layer->push_back(vertex);
+    }
+    layers.push_back(layer);
+  }
+
+  // the layout is as recent as the one it was taken from, and counts towards the memory budget
+  lastDrawn = old->lastDrawn ? old->lastDrawn : drawStamp;
+}
+
+/* hashes the shape of the region: the hashes of all nodes, the number of
+   arguments and results, and all edges given by region local port positions */
+void Region::computeHash() {
+  std::unordered_map<Element*,quint64> ports;
+
+  for(unsigned i = 0; i < arguments.size(); i++) {
+    ports[arguments[i]] = i;
+  }
+  for(unsigned k = 0; k < children.size(); k++) {
+    Node *node = (Node*)children[k];
+    for(unsigned i = 0; i < node->inputs.size(); i++) {
+      ports[node->inputs[i]] = ((quint64)(k+1) << 32) | i;
+    }
+  }
+  for(unsigned i = 0; i < results.size(); i++) {
+    ports[results[i]] = ((quint64)(children.size()+1) << 32) | i;
+  }
+
+  quint64 h = hashCombine(arguments.size(), results.size());
+  for(auto child : children) {
+    h = hashCombine(h, child->hash);
+  }
+
+  // edges from arguments and from node outputs
+  for(unsigned i = 0; i < arguments.size(); i++) {
+    for(auto edge : arguments[i]->edges) {
+      h = hashCombine(h, i);
+      h = hashCombine(h, ports.count(edge->target) ? ports[edge->target] : ~0ULL);
+    }
+  }
+  for(unsigned k = 0; k < children.size(); k++) {
+    Node *node = (Node*)children[k];
+    for(unsigned j = 0; j < node->outputs.size(); j++) {
+      for(auto edge : node->outputs[j]->edges) {
+        h = hashCombine(h, ((quint64)(k+1) << 32) | j);
+        h = hashCombine(h, ports.count(edge->target) ? ports[edge->target] : ~0ULL);
+      }
+    }
+  }
+
+  hash = h;
+}
+
+void Region::computeStats() {
+  Element::computeStats();
+
+  unsigned numEdges = 0;
+  for(auto argument : arguments) {
+    numEdges += argument->getNumEdges();
+  }
+  for(auto child : children) {
+    numEdges += child->getNumEdges();
+  }
+
+  stats->edges += numEdges;
+  stats->depth++;
+  stats->area += numEdges * ESTIMATED_EDGE_AREA;
+
+  for(auto argument : arguments) {
+    stats->maxFanout = std::max(stats->maxFanout, argument->getNumEdges());
+  }
+  for(auto child : children) {
+    for(auto output : ((Node*)child)->outputs) {
+      stats->maxFanout = std::max(stats->maxFanout, output->getNumEdges());
+    }
+  }
+
+  computePathStats();
+}
+
+/* computes the widest layer and the longest path of this region in linear time
+   the layers are the same as the ones built by layer(): results in layer 0,
+   and every node one layer above its highest successor
+   if longestPath is given, the nodes on the longest path are appended to it, top-down */
+void Region::computePathStats(std::vector<Element*> *longestPath) {
+  std::unordered_map<Element*,unsigned> index;
+  for(unsigned i = 0; i < children.size(); i++) {
+    index[children[i]] = i;
+  }
+
+  // successor and predecessor lists between nodes, results are left out
+  std::vector<std::vector<unsigned> > successors(children.size());
+  std::vector<std::vector<unsigned> > predecessors(children.size());
+  for(unsigned i = 0; i < children.size(); i++) {
+    for(unsigned e = 0; e < children[i]->getNumEdges(); e++) {
+      auto it = index.find(children[i]->getEdge(e)->target->getVertex());
+      if(it != index.end()) {
+        successors[i].push_back(it->second);
+        predecessors[it->second].push_back(i);
+      }
+    }
+  }
+
+  // visit nodes bottom-up, starting with the ones without node successors
+  std::vector<unsigned> remaining(children.size());
+  std::vector<unsigned> worklist;
+  for(unsigned i = 0; i < children.size(); i++) {
+    remaining[i] = successors[i].size();
+    if(!remaining[i]) worklist.push_back(i);
+  }
+
+  std::vector<unsigned> layerOf(children.size(), 1);
+  std::vector<unsigned> pathOf(children.size(), 0);
+  std::vector<int> nextOf(children.size(), -1); // successor on the longest path from each node
+  std::vector<unsigned> layerWidths(2, 0);
+  int first = -1; // start of the longest path
+
+  while(worklist.size()) {
+    unsigned v = worklist.back();
+    worklist.pop_back();
+
+    for(auto s : successors[v]) {
+      layerOf[v] = std::max(layerOf[v], layerOf[s] + 1);
+      if((nextOf[v] < 0) || (pathOf[s] > pathOf[nextOf[v]])) nextOf[v] = s;
+    }
+    pathOf[v] = ((nextOf[v] < 0) ? 0 : pathOf[nextOf[v]]) + children[v]->stats->longestPath;
+
+    if(layerOf[v] >= layerWidths.size()) layerWidths.resize(layerOf[v] + 1, 0);
+    layerWidths[layerOf[v]]++;
+    stats->longestPath = std::max(stats->longestPath, pathOf[v]);
+    if((first < 0) || (pathOf[v] > pathOf[first])) first = v;
+
+    for(auto p : predecessors[v]) {
+      if(!--remaining[p]) worklist.push_back(p);
+    }
+  }
+
+  stats->widestLayer = std::max(stats->widestLayer, (unsigned)results.size());
+  stats->widestLayer = std::max(stats->widestLayer, (unsigned)arguments.size());
+  for(auto width : layerWidths) {
+    stats->widestLayer = std::max(stats->widestLayer, width);
+  }
+
+  if(longestPath) {
+    for(int v = first; v >= 0; v = nextOf[v]) {
+      longestPath->push_back(children[v]);
+    }
   }
 }
 
@@ -142,20 +479,155 @@ Region::~Region() {
   }
 }
 
+template<typename T> static quint64 vectorBytes(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
+}
+
+/* the ports whose line segments are routed by this region */
+static void routedPorts(Region *region, std::vector<Element*> &ports) {
+  ports.insert(ports.end(), region->arguments.begin(), region->arguments.end());
+  ports.insert(ports.end(), region->results.begin(), region->results.end());
+  for(auto child : region->children) {
+    child->getPorts(ports);
+  }
+}
+
+quint64 Region::getLayoutMemory() {
+  if(!lastDrawn && layers.empty()) return 0;
+
+  quint64 bytes = vectorBytes(layers);
+  for(auto layer : layers) {
+    bytes += sizeof(*layer) + vectorBytes(*layer);
+  }
+  bytes += vectorBytes(slotVertices) + vectorBytes(slotRows) + vectorBytes(slotColumns)
+    + vectorBytes(slotX) + vectorBytes(slotY) + vectorBytes(slotWidths) + vectorBytes(slotHeights);
+
+  std::vector<Element*> ports;
+  routedPorts(this, ports);
+  for(auto port : ports) {
+    bytes += port->getLineSegmentMemory();
+  }
+
+  return bytes;
+}
+
+void Region::evictLayout() {
+  for(auto layer : layers) {
+    delete layer;
+  }
+  std::vector<std::vector<Element*>*>().swap(layers);
+
+  std::vector<Element*>().swap(slotVertices);
+  std::vector<unsigned>().swap(slotRows);
+  std::vector<unsigned>().swap(slotColumns);
+  std::vector<unsigned>().swap(slotX);
+  std::vector<unsigned>().swap(slotY);
+  std::vector<unsigned>().swap(slotWidths);
+  std::vector<unsigned>().swap(slotHeights);
+
+  std::vector<Element*> ports;
+  routedPorts(this, ports);
+  for(auto port : ports) {
+    port->releaseLineSegments();
+  }
+  releaseLineSegments();
+
+  lastDrawn = 0;
+}
+
+/* draws the region as a block showing its statistics, instead of its contents */
+void Region::appendSummaryItems(QGraphicsItem *parent) {
+  baseItem = ItemPool::polygon(parent);
+  baseItem->setBrush(QBrush(QColor(SUMMARY_COLOR)));
+  baseItem->setData(0, QVariant::fromValue((void*)this));
+
+  QString text = QString("Region %1\n").arg(id);
+  if(stats) text += stats->toString() + "\n";
+  text += "Double-click to draw contents";
+
+  QGraphicsTextItem *textItem = ItemPool::text(text, baseItem);
+  textItem->setPos(QPointF(TEXT_CLEARANCE, TEXT_CLEARANCE));
+  textItem->setData(0, QVariant::fromValue((void*)this));
+
+  width = textItem->boundingRect().width() + TEXT_CLEARANCE*2;
+  height = textItem->boundingRect().height() + TEXT_CLEARANCE*2;
+
+  QPolygonF polygon;
+  polygon << QPointF(0, 0)
+          << QPointF(width, 0)
+          << QPointF(width, height)
+          << QPointF(0, height);
+  baseItem->setPolygon(polygon);
+}
+
 void Region::appendItems(QGraphicsItem *parent) {
 
   clearLineSegments();
+  baseItem = NULL;
+  lastDrawn = drawStamp;
+
+  //-----------------------------------------------------------------------------
+  // oversized regions are drawn as a summary block, unless asked for
+
+  unsigned numVertices = children.size() + arguments.size() + results.size();
+  if(!showAll && (numVertices > drawBudget)) {
+    appendSummaryItems(parent);
+    return;
+  }
+  drawBudget -= std::min(drawBudget, numVertices);
 
   //-----------------------------------------------------------------------------
   // build layers for this region
 
   layer();
 
-  int rows = layers.size();
+  unsigned rows = layers.size();
 
   height = 0;
   width = 0;
 
+  //-----------------------------------------------------------------------------
+  // flatten the layers into layout slots, bottom layer first
+  // all layout state below is kept in per slot arrays
+
+  unsigned numSlots = 0;
+  for(auto layer : layers) {
+    numSlots += layer->size();
+  }
+
+  slotVertices.resize(numSlots);
+  slotRows.resize(numSlots);
+  slotColumns.resize(numSlots);
+  slotX.resize(numSlots);
+  slotY.resize(numSlots);
+  slotWidths.resize(numSlots);
+  slotHeights.resize(numSlots);
+  std::vector<unsigned> rowStarts(rows + 1);
+
+  unsigned slot = 0;
+  for(unsigned row = 0; row < rows; row++) {
+    rowStarts[row] = slot;
+    for(unsigned col = 0; col < layers[row]->size(); col++) {
+      Element *vertex = (*layers[row])[col];
+      slotVertices[slot] = vertex;
+      slotRows[slot] = row;
+      slotColumns[slot] = col;
+      slot++;
+    }
+  }
+  rowStarts[rows] = slot;
+
+  // slot of every vertex and port in this region, by element number
+  for(unsigned i = 0; i < numSlots; i++) {
+    std::vector<Element*> ports;
+    ports.push_back(slotVertices[i]);
+    slotVertices[i]->getPorts(ports);
+    for(auto port : ports) {
+      if(port->number >= slotOf.size()) slotOf.resize(port->number + 1);
+      slotOf[port->number] = i;
+    }
+  }
+
   //-----------------------------------------------------------------------------
   // build all vertex graphics items
   // need to do this now so that all vertex sizes are known during placement
@@ -166,46 +638,55 @@ void Region::appendItems(QGraphicsItem *parent) {
     }
   }
 
+  for(unsigned i = 0; i < numSlots; i++) {
+    slotWidths[i] = slotVertices[i]->getWidth();
+    slotHeights[i] = slotVertices[i]->getHeight();
+  }
+
+  // edges as pairs of slots, in routing order
+  std::vector<Edge*> edges;
+  std::vector<unsigned> edgeSources;
+  std::vector<unsigned> edgeTargets;
+  std::vector<unsigned> edgeNumbers; // edge number within its source vertex
+  for(unsigned i = 0; i < numSlots; i++) {
+    Element *vertex = slotVertices[i];
+    for(unsigned e = 0; e < vertex->getNumEdges(); e++) {
+      Edge *edge = vertex->getEdge(e);
+      edges.push_back(edge);
+      edgeSources.push_back(i);
+      edgeTargets.push_back(slotOf[edge->target->number]);
+      edgeNumbers.push_back(e);
+    }
+  }
+  unsigned numEdges = edges.size();
+
   //-----------------------------------------------------------------------------
   // calculate mesh positions for vertices and edges
 
   // find column widths
-  std::vector<unsigned> columnWidths(0);
-  for(auto layer = layers.rbegin(); layer != layers.rend(); layer++) {
-    // this layer has more columns than previous layers, increase columnWidths vector
-    if((*layer)->size() > columnWidths.size()) {
-      columnWidths.resize((*layer)->size(), 0);
-    }
-    // go through all vertices in this layer and update columnWidths if necessary
-    int i = 0;
-    for(auto vertex : *(*layer)) {
-      unsigned w = vertex->getWidth();
-      if(w > columnWidths[i]) columnWidths[i] = w;
-      i++;
-    }
+  unsigned columns = 0;
+  for(unsigned row = 0; row < rows; row++) {
+    columns = std::max(columns, rowStarts[row+1] - rowStarts[row]);
+  }
+  std::vector<unsigned> columnWidths(columns, 0);
+  for(unsigned i = 0; i < numSlots; i++) {
+    columnWidths[slotColumns[i]] = std::max(columnWidths[slotColumns[i]], slotWidths[i]);
   }
-
-  int columns = columnWidths.size();
 
   std::vector<unsigned> rowSpacing(rows, LINE_CLEARANCE);
   std::vector<unsigned> columnSpacing(columns+1, LINE_CLEARANCE);
 
   // find row and column spacing
   // this is based on the number of edges that must be routed here
-  for(auto layer : layers) {
-    for(auto vertex : *layer) {
-      for(unsigned i = 0; i < vertex->getNumEdges(); i++) {
-        unsigned sourceRow = vertex->getRow();
-        unsigned targetRow = vertex->getEdge(i)->target->getRow();
-        unsigned targetColumn = vertex->getEdge(i)->target->getColumn();
+  for(unsigned e = 0; e < numEdges; e++) {
+    unsigned sourceRow = slotRows[edgeSources[e]];
+    unsigned targetRow = slotRows[edgeTargets[e]];
 
-        rowSpacing[sourceRow] += LINE_CLEARANCE;
+    rowSpacing[sourceRow] += LINE_CLEARANCE;
 
-        if((sourceRow - targetRow) > 1) {
-          rowSpacing[targetRow+1] += LINE_CLEARANCE;
-          columnSpacing[targetColumn] += LINE_CLEARANCE;
-        }
-      }
+    if((sourceRow - targetRow) > 1) {
+      rowSpacing[targetRow+1] += LINE_CLEARANCE;
+      columnSpacing[slotColumns[edgeTargets[e]]] += LINE_CLEARANCE;
     }
   }
   columnSpacing[columns] = 0;
@@ -224,97 +705,93 @@ void Region::appendItems(QGraphicsItem *parent) {
   currentRoutingYs.resize(layers.size(), 0);
 
   //-----------------------------------------------------------------------------
-  // position vertices
+  // position vertices, top row first
 
-  unsigned xx = columnSpacing[0];
   unsigned yy = 2*LINE_CLEARANCE;
 
-  unsigned row = rows-1;
-
-  for(auto layer = layers.rbegin(); layer != layers.rend(); layer++) {
-
+  for(unsigned row = rows; row-- > 0;) {
     unsigned maxHeight = 0;
+    unsigned xx = columnSpacing[0];
 
-    unsigned col = 0;
     currentRoutingYs[row] = yy - LINE_CLEARANCE;
 
-    for(auto vertex : *(*layer)) {
-      unsigned w = vertex->getWidth();
-      unsigned h = vertex->getHeight();
+    for(unsigned i = rowStarts[row]; i < rowStarts[row+1]; i++) {
+      unsigned col = slotColumns[i];
+      unsigned w = slotWidths[i];
 
       unsigned xpos = (xx+(columnWidths[col]-w)/2);
       if(xpos % INPUTOUTPUT_CLEARANCE) {
         xpos += INPUTOUTPUT_CLEARANCE - (xpos % INPUTOUTPUT_CLEARANCE);
       }
 
-      vertex->setPos(xpos, yy);
+      slotX[i] = xpos;
+      slotY[i] = yy;
 
       xx += columnSpacing[col+1] + columnWidths[col];
-      if((xpos + w) > width) width = xpos + w;
-      if(h > maxHeight) maxHeight = h;
-      col++;
+      width = std::max(width, xpos + w);
+      maxHeight = std::max(maxHeight, slotHeights[i]);
     }
 
-    xx = columnSpacing[0];
     yy += rowSpacing[row] + maxHeight;
+  }
 
-    row--;
+  for(unsigned i = 0; i < numSlots; i++) {
+    slotVertices[i]->setPos(slotX[i], slotY[i]);
   }
 
+  storePositions();
+
   //-----------------------------------------------------------------------------
   // create and display edges
 
-  for(auto layer : layers) {
-    for(auto vertex : *layer) {
-      for(unsigned i = 0; i < vertex->getNumEdges(); i++) {
-        Element *source = NULL;
-        Edge *edge = vertex->getEdge(i, &source);
-        Element *target = edge->target;
-
-        std::vector<LineSegment> lines;
-
-        if((source->getRow() - target->getRow()) > 1) {
-          // edge is spanning more than one row
-          unsigned currentRoutingX = currentRoutingXs[target->getColumn()];
-          unsigned currentRoutingYSource = currentRoutingYs[source->getRow()-1];
-          unsigned currentRoutingYTarget = currentRoutingYs[target->getRow()];
-
-          lines.push_back(LineSegment(edge, new QGraphicsLineItem(source->getX(), source->getY(), source->getX(), currentRoutingYSource, parent)));
-          lines.push_back(LineSegment(edge, new QGraphicsLineItem(source->getX(), currentRoutingYSource, currentRoutingX, currentRoutingYSource, parent)));
-          lines.push_back(LineSegment(edge, new QGraphicsLineItem(currentRoutingX, currentRoutingYSource, currentRoutingX, currentRoutingYTarget, parent)));
-          lines.push_back(LineSegment(edge, new QGraphicsLineItem(currentRoutingX, currentRoutingYTarget, target->getX(), currentRoutingYTarget, parent)));
-          lines.push_back(LineSegment(edge, new QGraphicsLineItem(target->getX(), currentRoutingYTarget, target->getX(), target->getY(), parent)));
-      
-          currentRoutingXs[target->getColumn()] -= LINE_CLEARANCE;
-          currentRoutingYs[source->getRow()-1] -= LINE_CLEARANCE;
-          currentRoutingYs[target->getRow()] -= LINE_CLEARANCE;
-
-        } else {
-          // edge is between neighbouring rows
-          unsigned currentRoutingY = currentRoutingYs[source->getRow()-1];
-
-          lines.push_back(LineSegment(edge, new QGraphicsLineItem(source->getX(), source->getY(), source->getX(), currentRoutingY, parent)));
-          lines.push_back(LineSegment(edge, new QGraphicsLineItem(source->getX(), currentRoutingY, target->getX(), currentRoutingY, parent)));
-          lines.push_back(LineSegment(edge, new QGraphicsLineItem(target->getX(), currentRoutingY, target->getX(), target->getY(), parent)));
-      
-          currentRoutingYs[source->getRow()-1] -= LINE_CLEARANCE;
-        }
-
-        for(auto line : lines) {
-          QPen pen = line.item->pen();
-          if(edge->color == -1) {
-            pen.setColor(Qt::black);
-          } else {
-            pen.setColor(edgeColors[line.edge->color]);
-          }
-          line.item->setPen(pen);
-          line.item->setZValue(line.edge->zvalue);
-        }
+  for(unsigned e = 0; e < numEdges; e++) {
+    Edge *edge = edges[e];
+    Element *source = edge->source;
+    Element *target = edge->target;
+    unsigned sourceX = positionsX[source->number];
+    unsigned sourceY = positionsY[source->number];
+    unsigned targetX = positionsX[target->number];
+    unsigned targetY = positionsY[target->number];
+    unsigned sourceRow = slotRows[edgeSources[e]];
+    unsigned targetRow = slotRows[edgeTargets[e]];
+    unsigned targetColumn = slotColumns[edgeTargets[e]];
+
+    std::vector<LineSegment> lines;
+
+    if((sourceRow - targetRow) > 1) {
+      // edge is spanning more than one row
+      unsigned currentRoutingX = currentRoutingXs[targetColumn];
+      unsigned currentRoutingYSource = currentRoutingYs[sourceRow-1];
+      unsigned currentRoutingYTarget = currentRoutingYs[targetRow];
+
+      lines.push_back(LineSegment(edge, ItemPool::line(sourceX, sourceY, sourceX, currentRoutingYSource, parent)));
+      lines.push_back(LineSegment(edge, ItemPool::line(sourceX, currentRoutingYSource, currentRoutingX, currentRoutingYSource, parent)));
+      lines.push_back(LineSegment(edge, ItemPool::line(currentRoutingX, currentRoutingYSource, currentRoutingX, currentRoutingYTarget, parent)));
+      lines.push_back(LineSegment(edge, ItemPool::line(currentRoutingX, currentRoutingYTarget, targetX, currentRoutingYTarget, parent)));
+      lines.push_back(LineSegment(edge, ItemPool::line(targetX, currentRoutingYTarget, targetX, targetY, parent)));
+
+      currentRoutingXs[targetColumn] -= LINE_CLEARANCE;
+      currentRoutingYs[sourceRow-1] -= LINE_CLEARANCE;
+      currentRoutingYs[targetRow] -= LINE_CLEARANCE;
+
+    } else {
+      // edge is between neighbouring rows
+      unsigned currentRoutingY = currentRoutingYs[sourceRow-1];
+
+      lines.push_back(LineSegment(edge, ItemPool::line(sourceX, sourceY, sourceX, currentRoutingY, parent)));
+      lines.push_back(LineSegment(edge, ItemPool::line(sourceX, currentRoutingY, targetX, currentRoutingY, parent)));
+      lines.push_back(LineSegment(edge, ItemPool::line(targetX, currentRoutingY, targetX, targetY, parent)));
+
+      currentRoutingYs[sourceRow-1] -= LINE_CLEARANCE;
+    }
 
-        target->setLineSegments(i, lines);
-        vertex->setLineSegments(i, lines);
-      }
+    // colored by DiagramScene::recolor() once the whole scene is drawn
+    for(auto line : lines) {
+      line.item->setData(1, QVariant::fromValue((void*)line.edge));
     }
+
+    target->setLineSegments(edgeNumbers[e], lines);
+    slotVertices[edgeSources[e]]->setLineSegments(edgeNumbers[e], lines);
   }
 
   width += LINE_CLEARANCE;
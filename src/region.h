@@ -9,32 +9,80 @@
 #ifndef REGION_H
 #define REGION_H
 
+#include <unordered_map>
+
 #include "element.h"
 
+/* layering of a region shape, as indices into the vertices given by shapeHash() */
+typedef std::vector<std::vector<unsigned> > LayerShape;
+
+/* the exact shape hashed by shapeHash(): the argument, child and result counts
+   followed by the source and target index of every edge */
+typedef std::vector<unsigned> ShapeKey;
+
 class Region : public Element {
+  friend class MemoryReport;
 
   std::vector<std::vector<Element*>*> layers;
   unsigned width;
   unsigned height;
+  bool showAll; // draw contents even if over budget
+
+  // layout state as struct of arrays, indexed by slot (layers flattened, bottom layer first)
+  std::vector<Element*> slotVertices;
+  std::vector<unsigned> slotRows;
+  std::vector<unsigned> slotColumns;
+  std::vector<unsigned> slotX;
+  std::vector<unsigned> slotY;
+  std::vector<unsigned> slotWidths;
+  std::vector<unsigned> slotHeights;
+
+  static std::vector<unsigned> slotOf; // slot of each vertex and port of the region being drawn, by element number
+
+  unsigned lastDrawn; // drawStamp of the last draw including this region
 
   void layer();
+  quint64 signature();
+  quint64 shapeHash(std::vector<Element*> &vertices, ShapeKey &key);
+  void stampLayers(const LayerShape &shape, const std::vector<Element*> &vertices);
+  void cacheLayers(quint64 shape, ShapeKey &key, const std::vector<Element*> &vertices);
+  void storePositions();
 
 public:
   std::vector<Element*> arguments;
   std::vector<Element*> results;
 
-  Region(QString id, unsigned treeviewRow, Element *parent) : Element(id, treeviewRow, parent) {}
+  static unsigned drawBudget; // vertices left to draw before regions are summarized
+  static unsigned drawStamp;  // incremented for every draw of the scene
+
+  /* coordinates of vertices and ports, relative to the region they were last drawn in,
+     indexed by element number, filled in when the region layout is finalized */
+  static std::vector<unsigned> positionsX;
+  static std::vector<unsigned> positionsY;
+
+  Region(QString id, unsigned treeviewRow, Element *parent) : Element(id, treeviewRow, parent) {
+    width = height = 0;
+    showAll = false;
+    lastDrawn = 0;
+  }
   ~Region();
   Element *parseXmlElement(QString tagName, QString childId);
   QString getTypeName() {
     return QString("Region");
   }
+  bool isRegion() {
+    return true;
+  }
   void appendArgument(Element *e) {
     arguments.insert(arguments.end(), e);
   }
   void appendResult(Element *e) {
     results.insert(results.end(), e);
   }
+  void getPorts(std::vector<Element*> &ports) {
+    ports.insert(ports.end(), arguments.begin(), arguments.end());
+    ports.insert(ports.end(), results.begin(), results.end());
+  }
   unsigned getWidth() {
     return width;
   }
@@ -42,15 +90,26 @@ public:
     return height;
   }
   void appendItems(QGraphicsItem *item);
-  virtual void clearColors() {
-    Element::clearColors();
-    for(auto child : arguments) {
-      child->clearColors();
-    }
-    for(auto child : results) {
-      child->clearColors();
-    }
+  void appendSummaryItems(QGraphicsItem *item);
+  void setShowAll(bool showAll) {
+    this->showAll = showAll;
   }
+  void reuseLayers(Region *old);
+  void computeHash();
+  void computeStats();
+  void computePathStats(std::vector<Element*> *longestPath = NULL);
+
+  unsigned getLastDrawn() {
+    return lastDrawn;
+  }
+  /* bytes held by the layering, the layout arrays and the routed edges of this region */
+  quint64 getLayoutMemory();
+  /* frees the layout, it is rebuilt when the region is drawn again */
+  void evictLayout();
+
+  /* bytes held by the cache of layerings by region shape, and trimming it in LRU order */
+  static quint64 getLayerCacheMemory();
+  static void trimLayerCache(quint64 budget);
 };
 
 #endif
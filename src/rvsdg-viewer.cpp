@@ -1,20 +1,88 @@
 #include <QApplication>
+#include <QTextStream>
+#include <cstring>
 
 #include "mainwindow.h"
+#include "query.h"
 
 int main(int argc, char *argv[]) {
   Q_INIT_RESOURCE(application);
 
+  // --query <file> <queries>: evaluate ';' separated queries without the GUI, print JSON and exit
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "--query")) {
+      if(i + 2 >= argc) {
+        QTextStream(stderr) << "Usage: rvsdg-viewer --query <file> <queries>\n";
+        return 1;
+      }
+      QCoreApplication app(argc, argv);
+      return Query::run(QString::fromLocal8Bit(argv[i+1]), QString::fromLocal8Bit(argv[i+2]));
+    }
+  }
+
   QApplication app(argc, argv);
   app.setApplicationName("RVSDG Viewer");
 
+  QStringList args = QCoreApplication::arguments();
+
+  // --mem-report <file>: load and draw the file, print a memory breakdown and exit
+  bool memReport = args.removeAll("--mem-report") > 0;
+
+  // --replay <file>: load and draw the file, replay pan and zoom, print frame times and exit
+  bool replay = args.removeAll("--replay") > 0;
+
+  // --listen <name>: show graphs streamed by a compiler on the local socket name
+  QString listenName;
+  int listenIndex = args.indexOf("--listen");
+  if((listenIndex > 0) && (listenIndex + 1 < args.size())) {
+    listenName = args.at(listenIndex + 1);
+    args.removeAt(listenIndex + 1);
+    args.removeAt(listenIndex);
+  }
+
+  if(memReport) {
+    // runs without a visible window, so errors go to stderr rather than to a message box
+    if(args.size() < 2) {
+      QTextStream(stderr) << "Usage: rvsdg-viewer --mem-report <file>\n";
+      return 1;
+    }
+    QString error;
+    Model *model = readModel(args.at(1), error);
+    if(!model) {
+      QTextStream(stderr) << error << "\n";
+      return 1;
+    }
+    MainWindow *mainWin = new MainWindow(args.at(1), model);
+    if(!mainWin->drawTop()) {
+      QTextStream(stderr) << "Nothing to report, the file has no top level region\n";
+      return 1;
+    }
+    QTextStream(stdout) << mainWin->memoryReport();
+    return 0;
+  }
+
   MainWindow *mainWin;
 
-  if(QCoreApplication::arguments().size() > 1) {
-    mainWin = new MainWindow(QCoreApplication::arguments().at(1));
+  if(args.size() > 1) {
+    mainWin = new MainWindow(args.at(1));
   } else {
     mainWin = new MainWindow();
   }
-  mainWin->show();
+
+  mainWin->showMaximized();
+
+  if(!listenName.isEmpty()) mainWin->listen(listenName);
+
+  if(replay) {
+    // painting needs a visible, laid out window
+    if(!mainWin->drawTop()) {
+      QTextStream(stderr) << "Nothing to replay, the file has no top level region\n";
+      return 1;
+    }
+    app.processEvents();
+    QTextStream(stdout) << mainWin->replay();
+    return 0;
+  }
+
   return app.exec();
 }
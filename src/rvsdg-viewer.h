@@ -26,6 +26,12 @@
 #define ATTR_NAME    "name"
 #define ATTR_TYPE    "type"
 
+#define FILE_FILTER  "RVSDG files (*.rvsdg *.rvsdg.gz *.rvsdg.zst)"
+#define FILE_PATTERNS { "*.rvsdg", "*.rvsdg.gz", "*.rvsdg.zst" }
+
+#define DECOMPRESS_CHUNK_SIZE  (64*1024) // bytes read and inflated at a time
+#define DECOMPRESS_QUEUE_LENGTH 16       // decompressed chunks buffered ahead of the parser
+
 ///////////////////////////////////////////////////////////////////////////////
 // layout defines
 
@@ -35,11 +41,27 @@
 #define LINE_CLEARANCE         10
 #define REGION_CLEARANCE       10
 
+#define ESTIMATED_NODE_AREA    (150*80)
+#define ESTIMATED_EDGE_AREA    (LINE_CLEARANCE*150)
+
+#define SUMMARY_BUDGET         2000 // default max number of vertices drawn at once
+#define MEMORY_BUDGET          (256*1024*1024) // default bytes of layouts and hidden items kept between draws
+#define IDLE_ITEM_BYTES        256  // estimated size of a hidden graphics item
+
 #define NODE_COLOR        Qt::gray
 #define GAMMA_NODE_COLOR  Qt::green
 #define LAMBDA_NODE_COLOR Qt::blue
 #define THETA_NODE_COLOR  Qt::red
 #define PHI_NODE_COLOR    QColor(255,165,0)
+#define SUMMARY_COLOR     QColor(230,230,230)
+
+#define HEAT_COLD_HUE      0.66 // blue, hot is red
+#define HEAT_MAX_PEN_WIDTH 8
+
+#define DIFF_ADDED_COLOR   QColor(0,200,0)
+#define DIFF_REMOVED_COLOR QColor(220,0,0)
+#define DIFF_CHANGED_COLOR QColor(230,160,0)
+#define DIFF_PEN_WIDTH     4
 
 #define EDGE_COLORS { \
   Qt::red, \
@@ -57,10 +79,38 @@
   "Cyan" \
 }
 
+#define PATH_COLOR Qt::magenta // edges on a shortest path between two elements
+
+#define TRACE_NAMES { \
+  "Edges", \
+  "Forward trace", \
+  "Backward trace" \
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // gui defines
 
 #define SCALE_IN_FACTOR 1.25
 #define SCALE_OUT_FACTOR 0.8
+#define ZOOM_IDLE_DELAY  200 // ms without zooming before the scene is re-rendered at full quality
+
+#define SEARCH_MAX_HITS 200
+
+#define PICK_TOLERANCE 3 // distance from an edge segment still picking it
+
+#define RELOAD_DELAY 500 // ms to wait after a file change before reloading
+
+#define LIVE_SERVER_NAME "rvsdg-viewer"     // default local socket name for live streaming
+#define LIVE_BATCH_DELAY 100                // ms to collect updates not followed by a commit
+#define LIVE_MAX_FRAME   (256*1024*1024)    // larger frames are taken as a corrupt stream
+
+#define FRAME_STATS_WINDOW 1000 // frames kept for the frame time percentiles
+#define REPLAY_PAN_STEPS   40   // scroll positions visited per axis in a replay
+#define REPLAY_ZOOM_STEPS  10   // zoom steps in each direction in a replay
+
+#define TILE_SIZE          256                // tile width and height in pixels
+#define TILE_CACHE_BUDGET  (64*1024*1024)     // bytes of tile images kept
+#define SNAPSHOT_CELL_SIZE 512                // grid cell size of the scene snapshot index
+#define TILE_MISSING_COLOR QColor(240,240,240) // shown until a tile has been rendered
 
 #endif
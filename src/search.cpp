@@ -0,0 +1,59 @@
+#include <set>
+#include <algorithm>
+#include <string.h>
+
+#include "search.h"
+
+void SearchIndex::appendString(const QString &s, Element *owner) {
+  if(s.isEmpty()) return;
+
+  starts.push_back(text.size());
+  owners.push_back(owner);
+  text.append(s.toLower().toUtf8());
+  text.append('\0');
+}
+
+void SearchIndex::build() {
+  for(auto element : elements) {
+    appendString(element->id, element);
+    appendString(element->getName(), element);
+  }
+
+  const char *t = text.constData();
+
+  for(unsigned i = 0; i < (unsigned)text.size(); i++) {
+    if(t[i]) suffixes.push_back(i);
+  }
+
+  std::sort(suffixes.begin(), suffixes.end(), [t](unsigned a, unsigned b) {
+    return strcmp(t + a, t + b) < 0;
+  });
+
+  ready.storeRelease(1);
+}
+
+void SearchIndex::search(const QString &pattern, unsigned maxHits, std::vector<Element*> &hits) {
+  if(!isReady() || pattern.isEmpty()) return;
+
+  QByteArray p = pattern.toLower().toUtf8();
+  const char *t = text.constData();
+  const char *q = p.constData();
+  size_t len = p.size();
+
+  // all suffixes starting with the pattern are consecutive in the suffix array
+  auto it = std::lower_bound(suffixes.begin(), suffixes.end(), q, [t, len](unsigned s, const char *q) {
+    return strncmp(t + s, q, len) < 0;
+  });
+
+  std::set<Element*> found;
+
+  for(; (it != suffixes.end()) && (hits.size() < maxHits); it++) {
+    if(strncmp(t + *it, q, len)) break;
+
+    unsigned n = std::upper_bound(starts.begin(), starts.end(), *it) - starts.begin() - 1;
+    Element *element = owners[n];
+    if(found.insert(element).second) {
+      hits.push_back(element);
+    }
+  }
+}
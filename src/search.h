@@ -0,0 +1,42 @@
+/******************************************************************************
+ *
+ * Suffix array index over element names and ids
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <vector>
+#include <QByteArray>
+#include <QAtomicInt>
+
+#include "element.h"
+
+class SearchIndex {
+  std::vector<Element*> elements;
+  QByteArray text;                // lower case names and ids, each terminated by '\0'
+  std::vector<unsigned> starts;   // offset of each string in text
+  std::vector<Element*> owners;   // element owning each string
+  std::vector<unsigned> suffixes; // suffix array over text
+  QAtomicInt ready;
+
+  void appendString(const QString &s, Element *owner);
+
+public:
+  SearchIndex(const std::vector<Element*> &elements) : elements(elements), ready(0) {}
+
+  /* builds the index, may run in a background thread */
+  void build();
+
+  bool isReady() {
+    return ready.loadAcquire();
+  }
+
+  /* finds elements with a name or id containing pattern (case insensitive) */
+  void search(const QString &pattern, unsigned maxHits, std::vector<Element*> &hits);
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+
+#include "spatialindex.h"
+
+#define RTREE_NODE_SIZE 16
+
+/* sort-tile-recursive order: vertical slices sorted by x, each slice sorted by y,
+   so that consecutive runs of RTREE_NODE_SIZE items are spatially compact */
+template<typename T> static void strSort(std::vector<T> &items) {
+  std::sort(items.begin(), items.end(), [](const T &a, const T &b) {
+      return a.box.center().x() < b.box.center().x();
+    });
+
+  unsigned numGroups = (items.size() + RTREE_NODE_SIZE - 1) / RTREE_NODE_SIZE;
+  unsigned sliceSize = std::ceil(std::sqrt((double)numGroups)) * RTREE_NODE_SIZE;
+
+  for(unsigned start = 0; start < items.size(); start += sliceSize) {
+    auto end = items.begin() + std::min(start + sliceSize, (unsigned)items.size());
+    std::sort(items.begin() + start, end, [](const T &a, const T &b) {
+        return a.box.center().y() < b.box.center().y();
+      });
+  }
+}
+
+void SpatialIndex::build() {
+  nodes.clear();
+  if(entries.empty()) return;
+
+  strSort(entries);
+
+  // leaves
+  std::vector<TreeNode> level;
+  for(unsigned i = 0; i < entries.size(); i += RTREE_NODE_SIZE) {
+    TreeNode node;
+    node.first = i;
+    node.count = std::min((unsigned)RTREE_NODE_SIZE, (unsigned)entries.size() - i);
+    node.leaf = true;
+    node.box = entries[i].box;
+    for(unsigned e = i + 1; e < i + node.count; e++) {
+      node.box |= entries[e].box;
+    }
+    level.push_back(node);
+  }
+
+  // internal levels, each level is stored before its parents
+  while(level.size() > 1) {
+    strSort(level);
+
+    unsigned offset = nodes.size();
+    nodes.insert(nodes.end(), level.begin(), level.end());
+
+    std::vector<TreeNode> parents;
+    for(unsigned i = 0; i < level.size(); i += RTREE_NODE_SIZE) {
+      TreeNode node;
+      node.first = offset + i;
+      node.count = std::min((unsigned)RTREE_NODE_SIZE, (unsigned)level.size() - i);
+      node.leaf = false;
+      node.box = level[i].box;
+      for(unsigned n = i + 1; n < i + node.count; n++) {
+        node.box |= level[n].box;
+      }
+      parents.push_back(node);
+    }
+    level.swap(parents);
+  }
+
+  nodes.push_back(level[0]);
+}
+
+void SpatialIndex::query(const QRectF &rect, std::vector<const PickEntry*> &result) const {
+  if(nodes.empty()) return;
+
+  std::vector<unsigned> stack;
+  stack.push_back(nodes.size() - 1);
+
+  while(!stack.empty()) {
+    const TreeNode &node = nodes[stack.back()];
+    stack.pop_back();
+
+    if(!node.box.intersects(rect)) continue;
+
+    for(unsigned i = node.first; i < node.first + node.count; i++) {
+      if(node.leaf) {
+        if(entries[i].box.intersects(rect)) result.push_back(&entries[i]);
+      } else {
+        stack.push_back(i);
+      }
+    }
+  }
+}
+
+const PickEntry *SpatialIndex::pick(const QPointF &point) const {
+  std::vector<const PickEntry*> hits;
+  query(QRectF(point, QSizeF(1e-3, 1e-3)), hits);
+
+  const PickEntry *top = NULL;
+  for(auto hit : hits) {
+    if(hit->box.contains(point) && (!top || (hit->order > top->order))) top = hit;
+  }
+  return top;
+}
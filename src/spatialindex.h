@@ -0,0 +1,67 @@
+/******************************************************************************
+ *
+ * R-tree over the drawn geometry, used for picking
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <vector>
+#include <QRectF>
+
+#include "element.h"
+#include "edge.h"
+
+/* an element box or an edge segment, in scene coordinates */
+class PickEntry {
+public:
+  QRectF box;       // edge segments are widened by the pick tolerance
+  Element *element; // NULL for edge segments and for blocking areas (e.g. region backgrounds)
+  Edge *edge;       // NULL unless an edge segment
+  unsigned order;   // stacking order, higher is on top
+
+  PickEntry(const QRectF &box, Element *element, Edge *edge, unsigned order) {
+    this->box = box;
+    this->element = element;
+    this->edge = edge;
+    this->order = order;
+  }
+};
+
+/* static R-tree, bulk loaded with sort-tile-recursive packing */
+class SpatialIndex {
+  class TreeNode {
+  public:
+    QRectF box;
+    unsigned first; // first child node, or first entry for leaves
+    unsigned count;
+    bool leaf;
+  };
+
+  std::vector<PickEntry> entries;
+  std::vector<TreeNode> nodes; // children of a node are contiguous, root is last
+
+public:
+  void clear() {
+    entries.clear();
+    nodes.clear();
+  }
+
+  void insert(const PickEntry &entry) {
+    entries.push_back(entry);
+  }
+
+  /* packs the inserted entries into the tree, must be called before querying */
+  void build();
+
+  /* all entries with a box intersecting rect */
+  void query(const QRectF &rect, std::vector<const PickEntry*> &result) const;
+
+  /* topmost entry under point, NULL if none */
+  const PickEntry *pick(const QPointF &point) const;
+};
+
+#endif
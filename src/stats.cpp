@@ -0,0 +1,11 @@
+#include <cmath>
+
+#include "stats.h"
+
+QString SubtreeStats::toString() const {
+  return QString("%1 nodes (%2 simple, %3 lambda, %4 gamma, %5 theta, %6 phi)\n").arg(getNumNodes())
+    .arg(nodes[NODE]).arg(nodes[LAMBDA]).arg(nodes[GAMMA]).arg(nodes[THETA]).arg(nodes[PHI])
+    + QString("%1 edges, depth %2, max fanout %3\n").arg(edges).arg(depth).arg(maxFanout)
+    + QString("widest layer %1, longest path %2\n").arg(widestLayer).arg(longestPath)
+    + QString("estimated area %1 x %1").arg((quint64)sqrt((double)area));
+}
@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ * Aggregate statistics of a subtree of the RVSDG graph
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <QString>
+
+#include "node.h"
+
+class SubtreeStats {
+public:
+  unsigned nodes[NUM_NODE_TYPES]; // nodes in subtree, by type
+  unsigned edges;                 // edges in subtree
+  unsigned depth;                 // region nesting depth
+  quint64 area;                   // estimated layout area when fully expanded
+  unsigned maxFanout;             // max number of edges from one output or argument
+  unsigned widestLayer;           // max number of vertices in one layer of a region
+  unsigned longestPath;           // max number of nodes on a dataflow path, nested nodes included
+
+  SubtreeStats() {
+    clear();
+  }
+
+  void clear() {
+    std::fill(nodes, nodes + NUM_NODE_TYPES, 0);
+    edges = 0;
+    depth = 0;
+    area = 0;
+    maxFanout = 0;
+    widestLayer = 0;
+    longestPath = 0;
+  }
+
+  void add(const SubtreeStats &other) {
+    for(unsigned i = 0; i < NUM_NODE_TYPES; i++) {
+      nodes[i] += other.nodes[i];
+    }
+    edges += other.edges;
+    depth = std::max(depth, other.depth);
+    area += other.area;
+    maxFanout = std::max(maxFanout, other.maxFanout);
+    widestLayer = std::max(widestLayer, other.widestLayer);
+    longestPath = std::max(longestPath, other.longestPath);
+  }
+
+  unsigned getNumNodes() const {
+    unsigned n = 0;
+    for(unsigned i = 0; i < NUM_NODE_TYPES; i++) {
+      n += nodes[i];
+    }
+    return n;
+  }
+
+  QString toString() const;
+};
+
+#endif
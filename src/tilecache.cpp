@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cmath>
+#include <QtConcurrent>
+#include <QPainter>
+#include <QGraphicsItem>
+#include <QTextDocument>
+
+#include "tilecache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// scene snapshot
+
+SceneSnapshot::SceneSnapshot(QGraphicsScene *scene) {
+  QRectF sceneRect = scene->itemsBoundingRect().united(QRectF(0, 0, 1, 1));
+  columns = std::ceil(std::max(sceneRect.right(), 0.0) / SNAPSHOT_CELL_SIZE) + 1;
+  rows = std::ceil(std::max(sceneRect.bottom(), 0.0) / SNAPSHOT_CELL_SIZE) + 1;
+  cells.resize(columns * rows);
+
+  for(auto item : scene->items(Qt::AscendingOrder)) {
+    if(!item->isVisible()) continue;
+
+    Primitive primitive;
+    QTransform transform = item->sceneTransform();
+
+    if(QGraphicsLineItem *line = qgraphicsitem_cast<QGraphicsLineItem*>(item)) {
+      if(line->line().isNull()) continue;
+      primitive.type = LINE;
+      primitive.pen = line->pen();
+      primitive.polygon << transform.map(line->line().p1()) << transform.map(line->line().p2());
+    } else if(QGraphicsPolygonItem *poly = qgraphicsitem_cast<QGraphicsPolygonItem*>(item)) {
+      primitive.type = POLYGON;
+      primitive.pen = poly->pen();
+      primitive.brush = poly->brush();
+      primitive.polygon = transform.map(poly->polygon());
+    } else if(QGraphicsTextItem *text = qgraphicsitem_cast<QGraphicsTextItem*>(item)) {
+      primitive.type = TEXT;
+      primitive.pen = QPen(text->defaultTextColor());
+      primitive.font = text->font();
+      primitive.text = text->toPlainText();
+      qreal margin = text->document()->documentMargin();
+      primitive.pos = transform.map(QPointF(margin, margin));
+    } else {
+      continue;
+    }
+
+    unsigned n = primitives.size();
+    primitives.push_back(primitive);
+
+    // clamp to the grid, items outside the scene rect end up in the border cells
+    QRectF bounds = item->sceneBoundingRect();
+    int left = std::min(std::max((int)(bounds.left() / SNAPSHOT_CELL_SIZE), 0), columns - 1);
+    int right = std::min(std::max((int)(bounds.right() / SNAPSHOT_CELL_SIZE), 0), columns - 1);
+    int top = std::min(std::max((int)(bounds.top() / SNAPSHOT_CELL_SIZE), 0), rows - 1);
+    int bottom = std::min(std::max((int)(bounds.bottom() / SNAPSHOT_CELL_SIZE), 0), rows - 1);
+    for(int y = top; y <= bottom; y++) {
+      for(int x = left; x <= right; x++) {
+        cells[y * columns + x].push_back(n);
+      }
+    }
+  }
+}
+
+void SceneSnapshot::paint(QPainter *painter, const QRectF &rect) const {
+  int left = std::min(std::max((int)(rect.left() / SNAPSHOT_CELL_SIZE), 0), columns - 1);
+  int right = std::min(std::max((int)(rect.right() / SNAPSHOT_CELL_SIZE), 0), columns - 1);
+  int top = std::min(std::max((int)(rect.top() / SNAPSHOT_CELL_SIZE), 0), rows - 1);
+  int bottom = std::min(std::max((int)(rect.bottom() / SNAPSHOT_CELL_SIZE), 0), rows - 1);
+
+  std::vector<unsigned> visible;
+  for(int y = top; y <= bottom; y++) {
+    for(int x = left; x <= right; x++) {
+      const std::vector<unsigned> &cell = cells[y * columns + x];
+      visible.insert(visible.end(), cell.begin(), cell.end());
+    }
+  }
+
+  // primitive numbers are in stacking order
+  std::sort(visible.begin(), visible.end());
+  visible.erase(std::unique(visible.begin(), visible.end()), visible.end());
+
+  for(auto n : visible) {
+    const Primitive &primitive = primitives[n];
+    painter->setPen(primitive.pen);
+    switch(primitive.type) {
+      case LINE:
+        painter->drawLine(primitive.polygon[0], primitive.polygon[1]);
+        break;
+      case POLYGON:
+        painter->setBrush(primitive.brush);
+        painter->drawPolygon(primitive.polygon);
+        break;
+      case TEXT:
+        painter->setFont(primitive.font);
+        painter->drawText(QRectF(primitive.pos, QSizeF(1e6, 1e6)), Qt::AlignLeft | Qt::AlignTop, primitive.text);
+        break;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tile cache
+
+TileCache::TileCache(QGraphicsScene *scene, quint64 budget, QObject *parent) : QObject(parent), generation(new QAtomicInt(0)) {
+  this->scene = scene;
+  this->budget = budget;
+  bytes = 0;
+
+  connect(scene, SIGNAL(changed(QList<QRectF>)), this, SLOT(invalidate()));
+}
+
+qreal TileCache::levelScale(int level) {
+  return std::pow(SCALE_IN_FACTOR, level);
+}
+
+void TileCache::invalidate() {
+  snapshot.clear();
+  generation->ref();
+}
+
+const QImage *TileCache::getTile(const TileKey &key) {
+  int current = generation->load();
+
+  auto it = tiles.find(key);
+  if(it != tiles.end()) {
+    lru.splice(lru.begin(), lru, it->lru);
+    if(it->generation == current) return &it->image;
+  }
+
+  if(!pending.contains(key)) {
+    if(!snapshot) snapshot = QSharedPointer<const SceneSnapshot>(new SceneSnapshot(scene));
+
+    pending.insert(key);
+    QFutureWatcher<RenderedTile> *watcher = new QFutureWatcher<RenderedTile>(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(renderFinished()));
+    watcher->setFuture(QtConcurrent::run(render, snapshot, key, current, generation));
+  }
+
+  return (it != tiles.end()) ? &it->image : NULL;
+}
+
+/* renders one tile, may run in a background thread */
+TileCache::RenderedTile TileCache::render(QSharedPointer<const SceneSnapshot> snapshot, TileKey key, int generation,
+                                          QSharedPointer<QAtomicInt> currentGeneration) {
+  RenderedTile tile;
+  tile.key = key;
+  tile.generation = generation;
+
+  // the scene has changed since the tile was requested
+  if(currentGeneration->load() != generation) return tile;
+
+  qreal scale = levelScale(key.level);
+  QRectF rect(key.x * TILE_SIZE / scale, key.y * TILE_SIZE / scale, TILE_SIZE / scale, TILE_SIZE / scale);
+
+  tile.image = QImage(TILE_SIZE, TILE_SIZE, QImage::Format_RGB32);
+  tile.image.fill(Qt::white);
+
+  QPainter painter(&tile.image);
+  painter.setRenderHint(QPainter::TextAntialiasing);
+  painter.translate(-key.x * TILE_SIZE, -key.y * TILE_SIZE);
+  painter.scale(scale, scale);
+  snapshot->paint(&painter, rect);
+
+  return tile;
+}
+
+void TileCache::renderFinished() {
+  QFutureWatcher<RenderedTile> *watcher = static_cast<QFutureWatcher<RenderedTile>*>(sender());
+  RenderedTile tile = watcher->result();
+  watcher->deleteLater();
+
+  pending.remove(tile.key);
+
+  if(tile.image.isNull() || (tile.generation != generation->load())) {
+    // outdated, request again if the view still needs it
+    emit tileReady();
+    return;
+  }
+
+  insert(tile.key, tile.image, tile.generation);
+  emit tileReady();
+}
+
+void TileCache::insert(const TileKey &key, const QImage &image, int generation) {
+  auto it = tiles.find(key);
+  if(it != tiles.end()) {
+    bytes -= it->image.sizeInBytes();
+    lru.erase(it->lru);
+    tiles.erase(it);
+  }
+
+  lru.push_front(key);
+  Tile tile;
+  tile.image = image;
+  tile.generation = generation;
+  tile.lru = lru.begin();
+  tiles.insert(key, tile);
+  bytes += image.sizeInBytes();
+
+  // evict least recently used tiles, but never the one just inserted
+  while((bytes > budget) && (lru.size() > 1)) {
+    auto oldest = tiles.find(lru.back());
+    bytes -= oldest->image.sizeInBytes();
+    tiles.erase(oldest);
+    lru.pop_back();
+  }
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ * Cache of pre-rendered scene tiles, rendered in background threads
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <list>
+#include <vector>
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QImage>
+#include <QPen>
+#include <QBrush>
+#include <QFont>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QGraphicsScene>
+
+#include "rvsdg-viewer.h"
+
+/* tile position at a zoom level, level n is scale SCALE_IN_FACTOR^n */
+class TileKey {
+public:
+  int level;
+  int x;
+  int y;
+
+  TileKey(int level, int x, int y) {
+    this->level = level;
+    this->x = x;
+    this->y = y;
+  }
+  bool operator==(const TileKey &other) const {
+    return (level == other.level) && (x == other.x) && (y == other.y);
+  }
+};
+
+inline uint qHash(const TileKey &key, uint seed = 0) {
+  return qHash(((quint64)(quint16)key.level << 48) ^ ((quint64)(quint32)key.x << 24) ^ (quint32)key.y, seed);
+}
+
+/* immutable copy of the scene geometry, safe to paint from any thread */
+class SceneSnapshot {
+public:
+  enum PrimitiveType {
+    LINE, POLYGON, TEXT
+  };
+
+  class Primitive {
+  public:
+    PrimitiveType type;
+    QPen pen;
+    QBrush brush;
+    QPolygonF polygon; // scene coordinates, two points for lines
+    QFont font;
+    QString text;
+    QPointF pos;       // top left of text
+  };
+
+private:
+  std::vector<Primitive> primitives; // in stacking order, bottom first
+  std::vector<std::vector<unsigned> > cells; // primitives intersecting each grid cell
+  int columns;
+  int rows;
+
+public:
+  SceneSnapshot(QGraphicsScene *scene);
+
+  /* paints the part of the snapshot inside rect (scene coordinates) */
+  void paint(QPainter *painter, const QRectF &rect) const;
+};
+
+class TileCache : public QObject {
+  Q_OBJECT
+
+  class Tile {
+  public:
+    QImage image;
+    int generation; // snapshot generation the tile was rendered from
+    std::list<TileKey>::iterator lru;
+  };
+
+  class RenderedTile {
+  public:
+    TileKey key;
+    int generation;
+    QImage image;
+
+    RenderedTile() : key(0, 0, 0) {
+      generation = 0;
+    }
+  };
+
+  QGraphicsScene *scene;
+  QHash<TileKey,Tile> tiles;
+  std::list<TileKey> lru; // most recently used first
+  QSet<TileKey> pending;
+  quint64 bytes;
+  quint64 budget;
+  QSharedPointer<const SceneSnapshot> snapshot; // NULL when the scene has changed
+  QSharedPointer<QAtomicInt> generation;        // shared with the render tasks
+
+  static RenderedTile render(QSharedPointer<const SceneSnapshot> snapshot, TileKey key, int generation,
+                             QSharedPointer<QAtomicInt> currentGeneration);
+  void insert(const TileKey &key, const QImage &image, int generation);
+
+public:
+  TileCache(QGraphicsScene *scene, quint64 budget, QObject *parent = 0);
+
+  /* returns the tile, or NULL if it is not cached yet
+     missing and outdated tiles are rendered in the background, outdated
+     tiles are still returned until they have been replaced */
+  const QImage *getTile(const TileKey &key);
+
+  static qreal levelScale(int level);
+
+public slots:
+  void invalidate();
+
+signals:
+  void tileReady();
+
+private slots:
+  void renderFinished();
+};
+
+#endif
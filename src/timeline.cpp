@@ -0,0 +1,92 @@
+#include <map>
+#include <algorithm>
+
+#include "timeline.h"
+
+/* true if both subtrees have the same ids everywhere */
+static bool sameIds(Element *a, Element *b) {
+  if((a->id != b->id) || (a->children.size() != b->children.size())) return false;
+
+  std::vector<Element*> portsA;
+  std::vector<Element*> portsB;
+  a->getPorts(portsA);
+  b->getPorts(portsB);
+  if(portsA.size() != portsB.size()) return false;
+  for(unsigned i = 0; i < portsA.size(); i++) {
+    if(portsA[i]->id != portsB[i]->id) return false;
+  }
+
+  for(unsigned i = 0; i < a->children.size(); i++) {
+    if(!sameIds(a->children[i], b->children[i])) return false;
+  }
+
+  return true;
+}
+
+/* replaces regions below newEl with identical regions below oldEl
+   regions are closed under edges, so they can be shared as a whole */
+void Timeline::share(Element *oldEl, Element *newEl) {
+  if(newEl->isRegion()) {
+    // nodes in a region are matched by id
+    std::map<QString,Element*> oldById;
+    for(auto child : oldEl->children) {
+      oldById[child->id] = child;
+    }
+    for(auto child : newEl->children) {
+      auto it = oldById.find(child->id);
+      if(it != oldById.end()) share(it->second, child);
+    }
+
+  } else {
+    // regions in a node are matched by position
+    for(unsigned i = 0; (i < oldEl->children.size()) && (i < newEl->children.size()); i++) {
+      Element *oldChild = oldEl->children[i];
+      Element *newChild = newEl->children[i];
+
+      if(oldChild->isRegion() && newChild->isRegion() &&
+         (oldChild->hash == newChild->hash) && sameIds(oldChild, newChild)) {
+        newEl->children[i] = oldChild;
+        delete newChild;
+
+        borrowed.back().push_back(ChildRef(newEl, i));
+        shared.back().push_back(ChildRef(newEl, i));
+        shared[shared.size()-2].push_back(ChildRef(oldEl, i));
+
+      } else {
+        share(oldChild, newChild);
+      }
+    }
+  }
+}
+
+void Timeline::append(const QString &fileName, Model *model) {
+  fileNames.push_back(fileName);
+  snapshots.push_back(model);
+  borrowed.resize(snapshots.size());
+  shared.resize(snapshots.size());
+
+  model->computeHashes();
+
+  if(snapshots.size() > 1) {
+    Model *previous = snapshots[snapshots.size()-2];
+    share(previous->getTop(), model->getTop());
+    model->rebuildIndex();
+  }
+}
+
+void Timeline::activate(unsigned n) {
+  for(auto ref : shared[n]) {
+    ref.first->children[ref.second]->parent = ref.first;
+  }
+  snapshots[n]->renumber();
+}
+
+Timeline::~Timeline() {
+  // delete the latest snapshots first, detaching borrowed regions so they are deleted by their owner
+  for(unsigned n = snapshots.size(); n > 0; n--) {
+    for(auto ref : borrowed[n-1]) {
+      ref.first->children[ref.second] = NULL;
+    }
+    delete snapshots[n-1];
+  }
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+ *
+ * Sequence of snapshots of the same RVSDG, e.g. one per optimization pass
+ * Unchanged regions are shared between neighbouring snapshots
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <QString>
+
+#include "model.h"
+
+typedef std::pair<Element*,unsigned> ChildRef; // node and child index
+
+class Timeline {
+  std::vector<QString> fileNames;
+  std::vector<Model*> snapshots;
+  std::vector<std::vector<ChildRef> > borrowed; // regions owned by an earlier snapshot
+  std::vector<std::vector<ChildRef> > shared;   // all regions used by more than one snapshot
+
+  void share(Element *oldEl, Element *newEl);
+
+public:
+  ~Timeline();
+
+  /* appends a snapshot, taking ownership of the model */
+  void append(const QString &fileName, Model *model);
+
+  /* makes the parent pointers and numbering of shared elements refer to snapshot n */
+  void activate(unsigned n);
+
+  unsigned size() {
+    return snapshots.size();
+  }
+  Model *getSnapshot(unsigned n) {
+    return snapshots[n];
+  }
+  QString getFileName(unsigned n) {
+    return fileNames[n];
+  }
+  bool owns(Model *model) {
+    return std::find(snapshots.begin(), snapshots.end(), model) != snapshots.end();
+  }
+};
+
+#endif
@@ -0,0 +1,159 @@
+/******************************************************************************
+ *
+ * Reference client for live streaming: replays an RVSDG file to a viewer
+ * started with --listen, either as one snapshot or as incremental updates
+ *
+ * agent 2026
+ *
+ *****************************************************************************/
+
+#include <QCoreApplication>
+#include <QDomDocument>
+#include <QFile>
+#include <QLocalSocket>
+#include <QTextStream>
+#include <QThread>
+#include <vector>
+
+#include "liveframe.h"
+
+class Sender {
+  QLocalSocket *socket;
+  unsigned batch;  // updates per commit
+  unsigned delay;  // ms to wait after each commit
+  unsigned count;  // updates since the last commit
+
+public:
+  unsigned frames;
+
+  Sender(QLocalSocket *socket, unsigned batch, unsigned delay) {
+    this->socket = socket;
+    this->batch = batch;
+    this->delay = delay;
+    count = frames = 0;
+  }
+
+  bool send(const LiveFrame &frame) {
+    socket->write(frame.encode());
+    frames++;
+
+    if(frame.op == LIVE_COMMIT) {
+      count = 0;
+      if(!socket->waitForBytesWritten(-1) && socket->bytesToWrite()) return false;
+      if(delay) QThread::msleep(delay);
+    } else if(++count >= batch) {
+      return send(LiveFrame(LIVE_COMMIT));
+    }
+
+    return socket->state() == QLocalSocket::ConnectedState;
+  }
+
+  /* sends element and its subtree as one add per element, parents first */
+  bool sendTree(const QDomElement &element, const QString &parentId, std::vector<QDomElement> &edges) {
+    for(QDomElement child = element.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+      if(child.tagName() == TAG_EDGE) {
+        edges.push_back(child);
+        continue;
+      }
+
+      QString id = child.attribute(ATTR_ID);
+      if(id.isEmpty()) continue;
+
+      // the element alone, its children are sent separately
+      LiveFrame frame(LIVE_ADD);
+      frame.id = parentId;
+      QTextStream stream(&frame.xml);
+      stream.setCodec("UTF-8");
+      child.cloneNode(false).save(stream, -1);
+      stream.flush();
+
+      if(!send(frame)) return false;
+      if(!sendTree(child, id, edges)) return false;
+    }
+
+    return true;
+  }
+};
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  QStringList args = QCoreApplication::arguments();
+  args.removeFirst();
+
+  bool snapshot = false;
+  unsigned batch = 100;
+  unsigned delay = 0;
+  QString serverName = LIVE_SERVER_NAME;
+  QString fileName;
+
+  while(!args.isEmpty()) {
+    QString arg = args.takeFirst();
+    if(arg == "--snapshot") snapshot = true;
+    else if((arg == "--batch") && !args.isEmpty()) batch = qMax(1u, args.takeFirst().toUInt());
+    else if((arg == "--delay") && !args.isEmpty()) delay = args.takeFirst().toUInt();
+    else if((arg == "--server") && !args.isEmpty()) serverName = args.takeFirst();
+    else fileName = arg;
+  }
+
+  if(fileName.isEmpty()) {
+    err << "Usage: rvsdg-send [--snapshot] [--batch <updates>] [--delay <ms>] [--server <name>] <file>\n";
+    return 1;
+  }
+
+  QFile file(fileName);
+  if(!file.open(QIODevice::ReadOnly)) {
+    err << fileName << ": File not found\n";
+    return 1;
+  }
+
+  QLocalSocket socket;
+  socket.connectToServer(serverName);
+  if(!socket.waitForConnected()) {
+    err << serverName << ": " << socket.errorString() << "\n";
+    return 1;
+  }
+
+  Sender sender(&socket, batch, delay);
+  bool ok;
+
+  if(snapshot) {
+    LiveFrame frame(LIVE_SNAPSHOT);
+    frame.xml = file.readAll();
+    ok = sender.send(frame) && sender.send(LiveFrame(LIVE_COMMIT));
+
+  } else {
+    QDomDocument doc;
+    if(!doc.setContent(&file)) {
+      err << fileName << ": Invalid XML file\n";
+      return 1;
+    }
+
+    // all vertices first, edges may refer to elements anywhere in the file
+    std::vector<QDomElement> edges;
+    ok = sender.sendTree(doc.documentElement(), "", edges);
+
+    for(unsigned i = 0; ok && (i < edges.size()); i++) {
+      LiveFrame frame(LIVE_ADD_EDGE);
+      frame.id = edges[i].attribute(ATTR_SOURCE);
+      frame.key = edges[i].attribute(ATTR_TARGET);
+      ok = sender.send(frame);
+    }
+
+    if(ok) ok = sender.send(LiveFrame(LIVE_COMMIT));
+  }
+
+  if(!ok) {
+    err << serverName << ": " << socket.errorString() << "\n";
+    return 1;
+  }
+
+  socket.disconnectFromServer();
+  if(socket.state() != QLocalSocket::UnconnectedState) socket.waitForDisconnected();
+
+  out << "Sent " << sender.frames << " frames\n";
+
+  return 0;
+}
@@ -0,0 +1,9 @@
+QT       = core xml network
+CONFIG  += console
+CONFIG  -= app_bundle
+QMAKE_CXXFLAGS += -g -std=gnu++11
+
+INCLUDEPATH += ../../src
+
+HEADERS       = ../../src/liveframe.h ../../src/rvsdg-viewer.h
+SOURCES       = main.cpp